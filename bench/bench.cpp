@@ -0,0 +1,338 @@
+/*
+benchmark harness for every day
+
+for each day, part and input scale the day binary is run repeatedly as a child process
+(each day is its own program reading "input.txt" from its working directory),
+and the results are printed as JSON:
+- median and p99 wall time of the runs
+- throughput of the median run in MB/s
+- peak RSS of the child (from wait4)
+- for days that name their records (task_2 rounds), the records per second of the median run
+
+the scaled inputs are built next to the binaries by repeating the day input N times,
+days whose format can not be repeated (task_8 has a fixed board size) only run at x1.
+task_6 would find both markers in the first copy, its scaled inputs come from gen_input with
+the markers at the very end.
+task_11 is left out, it has no solution yet (its main() only plays a test game).
+the days run with the parse cache off (AOC_NO_CACHE=1), task_7 and task_8 also have a "cached"
+variant that fills the cache with an untimed run and then times the hits.
+
+usage: bench [--build-dir DIR] [--repeat N] [--scales 1,10,100,1000] [--days task_1,task_2]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+typedef struct
+{
+    string name;             // reported as "variant", "default" for the plain run
+    vector<string> extra_args; // appended after the part argument
+    bool use_cache = false;  // every other variant runs with AOC_NO_CACHE=1 (utils/parse_cache.h)
+} bench_variant_s;
+
+typedef struct
+{
+    string name;       // task directory, also the binary name in the build directory
+    vector<int> parts;
+    bool is_scalable;  // can the input be repeated and stay valid
+    string separator;  // written between two copies of the input
+    vector<bench_variant_s> variants;
+    string record_unit; // non empty: every line is a record, reported as "<unit>" and "<unit>_per_s"
+    bool is_generated = false; // the scaled inputs come from gen_input instead of copies of the day input
+} bench_day_s;
+
+typedef struct
+{
+    vector<double> wall_ms;
+    long peak_rss_kb = 0;
+    int failed_runs = 0;
+} bench_result_s;
+
+const vector<bench_day_s> DAYS =
+{
+    {"task_1",  {1, 2}, true,  "\n", {{"default", {}}, {"threads", {"--threads", "0"}}, {"simd", {"--simd"}}}, ""}, // an extra blank line keeps the groups apart
+    {"task_2",  {1, 2}, true,  "",   {{"default", {}}, {"simd", {"--simd"}}, {"threads", {"--threads", "0", "--simd"}}}, "rounds"},
+    {"task_3",  {1, 2}, true,  "",   {{"default", {}}, {"simd", {"--simd"}}, {"threads", {"--threads", "0", "--simd"}}}, ""}, // 300 lines, copies keep the groups of 3 aligned
+    {"task_4",  {1, 2}, true,  "",   {{"default", {}}}, ""},
+    {"task_6",  {1, 2}, true,  "",   {{"default", {}}}, "", true}, // copies would repeat the markers of the first one
+    {"task_7",  {1, 2}, true,  "",   {{"default", {}}, {"cached", {}, true}}, ""}, // every copy starts with "$ cd /"
+    {"task_8",  {1, 2}, false, "",   {{"default", {}}, {"cached", {}, true}}, ""},
+    {"task_9",  {1, 2}, true,  "",   {{"default", {}}}, ""},
+    {"task_10", {1},    true,  "",   {{"default", {}}}, ""}, // both parts are a single pass
+};
+
+vector<string> split(const string& str, char sep)
+{
+    vector<string> result;
+    stringstream stream(str);
+    string item;
+    while(getline(stream, item, sep))
+    {
+        if(!item.empty())
+            result.push_back(item);
+    }
+    return result;
+}
+
+string read_file(const string& path)
+{
+    ifstream file(path, ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+/*
+creates <build_dir>/bench_data/<day>/x<scale>/input.txt and returns the directory
+an existing file is reused only if it is newer than the day input (and gen_input for the generated
+days) and has the size of scale copies of it (with their separators), so a changed input or
+separator rebuilds it. the generated inputs (task_6) are the size of scale copies, from the same seed.
+*/
+string prepare_input(const string& build_dir, const bench_day_s& day, uint32_t scale, uint64_t& input_bytes)
+{
+    string dir = build_dir + "/bench_data/" + day.name + "/x" + to_string(scale);
+    string path = dir + "/input.txt";
+    string source_path = day.name + "/input.txt";
+    string generator_path = build_dir + "/gen_input";
+    bool is_generated = day.is_generated && scale > 1; // x1 is the day input
+    string original = read_file(source_path);
+    // keep the last line of the previous copy intact
+    string separator = (!original.empty() && original.back() != '\n') ? "\n" + day.separator : day.separator;
+    uint64_t expected_bytes = uint64_t(original.size()) * scale;
+    if(!is_generated)
+        expected_bytes += uint64_t(separator.size()) * (scale - 1);
+
+    struct stat source_stat, generator_stat, path_stat;
+    if(stat(source_path.c_str(), &source_stat) != 0)
+    {
+        throw runtime_error("failed to read " + source_path);
+    }
+    if(is_generated && stat(generator_path.c_str(), &generator_stat) != 0)
+    {
+        throw runtime_error(generator_path + " not found, run make first");
+    }
+    if(stat(path.c_str(), &path_stat) == 0 && uint64_t(path_stat.st_size) == expected_bytes &&
+       path_stat.st_mtime >= source_stat.st_mtime && (!is_generated || path_stat.st_mtime >= generator_stat.st_mtime))
+    {
+        input_bytes = path_stat.st_size;
+        return dir;
+    }
+    string mkdir_cmd = "mkdir -p " + dir;
+    if(system(mkdir_cmd.c_str()) != 0)
+    {
+        throw runtime_error("failed to create " + dir);
+    }
+    if(is_generated)
+    {
+        string generate_cmd = generator_path + " " + day.name + " --size " + to_string(expected_bytes) + " --out " + path;
+        if(system(generate_cmd.c_str()) != 0)
+        {
+            throw runtime_error("failed to generate " + path);
+        }
+    }
+    else
+    {
+        ofstream output(path, ios::binary);
+        for(uint32_t i = 0; i < scale; i++)
+        {
+            if(i > 0)
+                output << separator;
+            output << original;
+        }
+    }
+    stat(path.c_str(), &path_stat);
+    input_bytes = path_stat.st_size;
+    return dir;
+}
+
+/*
+runs the binary once in work_dir with stdout/stderr discarded
+the parse cache is off unless use_cache is set, so a run parses the text like the first one
+returns false if the child could not run or exited with an error
+*/
+bool run_once(const string& binary, const vector<string>& args, const string& work_dir, bool use_cache, double& wall_ms, long& max_rss_kb)
+{
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        return false;
+    }
+    if(pid == 0)
+    {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        if(chdir(work_dir.c_str()) != 0)
+            _exit(127);
+        if(use_cache)
+            unsetenv("AOC_NO_CACHE");
+        else
+            setenv("AOC_NO_CACHE", "1", 1);
+        vector<char*> argv;
+        argv.push_back(const_cast<char*>(binary.c_str()));
+        for(const string& arg : args)
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+        execv(binary.c_str(), argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    struct rusage usage;
+    if(wait4(pid, &status, 0, &usage) < 0)
+    {
+        return false;
+    }
+    wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    max_rss_kb = usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/*
+number of non empty lines of the file
+*/
+uint64_t count_records(const string& path)
+{
+    ifstream file(path, ios::binary);
+    uint64_t count = 0;
+    string line;
+    while(getline(file, line))
+    {
+        if(!line.empty() && line != "\r")
+            count++;
+    }
+    return count;
+}
+
+double percentile(vector<double> values, double fraction)
+{
+    if(values.empty())
+        return 0;
+    sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(ceil(fraction * values.size()));
+    index = (index == 0) ? 0 : index - 1;
+    return values[min(index, values.size() - 1)];
+}
+
+int main(int argc, char* argv[])
+{
+    string build_dir = "build";
+    uint32_t repeat = 5;
+    vector<uint32_t> scales = {1, 10, 100, 1000};
+    vector<string> selected_days;
+
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        string flag = argv[i], value = argv[i + 1];
+        if(flag == "--build-dir")
+            build_dir = value;
+        else if(flag == "--repeat")
+            repeat = stoul(value);
+        else if(flag == "--scales")
+        {
+            scales.clear();
+            for(const string& scale : split(value, ','))
+                scales.push_back(stoul(scale));
+        }
+        else if(flag == "--days")
+            selected_days = split(value, ',');
+        else
+        {
+            cerr << "unknown flag " << flag << endl;
+            return 1;
+        }
+    }
+
+    char resolved[PATH_MAX];
+    if(!realpath(build_dir.c_str(), resolved))
+    {
+        cerr << "build directory " << build_dir << " not found, run make first" << endl;
+        return 1;
+    }
+    build_dir = resolved;
+
+    cout << "{\n  \"repeat\": " << repeat << ",\n  \"results\": [";
+    bool is_first = true;
+    for(const bench_day_s& day : DAYS)
+    {
+        if(!selected_days.empty() && find(selected_days.begin(), selected_days.end(), day.name) == selected_days.end())
+            continue;
+        string binary = build_dir + "/" + day.name;
+        for(uint32_t scale : scales)
+        {
+            if(!day.is_scalable && scale != 1)
+                continue;
+            uint64_t input_bytes = 0;
+            string work_dir = prepare_input(build_dir, day, scale, input_bytes);
+            uint64_t num_records = day.record_unit.empty() ? 0 : count_records(work_dir + "/input.txt");
+            for(const bench_variant_s& variant : day.variants)
+            {
+                for(int part : day.parts)
+                {
+                    vector<string> args = {to_string(part)};
+                    args.insert(args.end(), variant.extra_args.begin(), variant.extra_args.end());
+
+                    bench_result_s result;
+                    if(variant.use_cache)
+                    {
+                        // an untimed run stores the entry, every timed run is a hit
+                        double wall_ms = 0;
+                        long rss_kb = 0;
+                        run_once(binary, args, work_dir, true, wall_ms, rss_kb);
+                    }
+                    for(uint32_t run = 0; run < repeat; run++)
+                    {
+                        double wall_ms = 0;
+                        long rss_kb = 0;
+                        if(!run_once(binary, args, work_dir, variant.use_cache, wall_ms, rss_kb))
+                        {
+                            result.failed_runs++;
+                            continue;
+                        }
+                        result.wall_ms.push_back(wall_ms);
+                        result.peak_rss_kb = max(result.peak_rss_kb, rss_kb);
+                    }
+
+                    double median_ms = percentile(result.wall_ms, 0.5);
+                    double p99_ms = percentile(result.wall_ms, 0.99);
+                    double throughput = (median_ms > 0) ? (input_bytes / 1e6) / (median_ms / 1e3) : 0;
+                    char records[160] = "";
+                    if(!day.record_unit.empty())
+                    {
+                        double records_per_s = (median_ms > 0) ? num_records / (median_ms / 1e3) : 0;
+                        snprintf(records, sizeof(records), ", \"%s\": %llu, \"%s_per_s\": %.0f", day.record_unit.c_str(),
+                                 (unsigned long long)num_records, day.record_unit.c_str(), records_per_s);
+                    }
+                    char line[768];
+                    snprintf(line, sizeof(line),
+                             "%s\n    {\"day\": \"%s\", \"part\": %d, \"variant\": \"%s\", \"scale\": %u, \"input_bytes\": %llu, "
+                             "\"median_ms\": %.3f, \"p99_ms\": %.3f, \"throughput_mb_s\": %.2f%s, \"peak_rss_kb\": %ld, \"failed_runs\": %d}",
+                             is_first ? "" : ",", day.name.c_str(), part, variant.name.c_str(), scale, (unsigned long long)input_bytes,
+                             median_ms, p99_ms, throughput, records, result.peak_rss_kb, result.failed_runs);
+                    cout << line << flush;
+                    is_first = false;
+                }
+            }
+        }
+    }
+    cout << "\n  ]\n}" << endl;
+}
@@ -0,0 +1,433 @@
+/*
+synthetic input generator for every day
+
+writes a valid input of (roughly) the requested size in the format of the given day,
+the same seed always produces the same bytes.
+
+usage: gen_input <day> [--size BYTES] [--seed N] [--out PATH]
+                       [--rows N --cols N]           (task_8)
+                       [--depth N --fanout N]        (task_7)
+                       [--monkeys N]                 (task_11)
+
+days and formats:
+- task_1  calorie groups, blank line separated
+- task_2  rock paper scissors rounds "A Y"
+- task_3  rucksacks, the halves of every line share exactly one item, every group of 3 lines shares exactly one badge
+- task_4  range pairs "2-4,6-8"
+- task_6  marker stream, no 4 distinct characters in a row until the very end
+- task_7  "$ cd" / "$ ls" transcript, trees of the given depth and fan-out are added under / until the size is reached,
+          the files always fit the puzzle disk (too many of them to fit is an error)
+- task_8  NxM tree height grid (the size is ignored)
+- task_9  rope moves "R 4"
+- task_10 cpu program of noop / addx
+- task_11 monkey definitions (the size is ignored)
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef struct
+{
+    uint64_t size = 1 << 20;
+    uint64_t seed = 1;
+    string out_path;
+    uint32_t rows = 99;
+    uint32_t cols = 99;
+    uint32_t depth = 4;
+    uint32_t fanout = 3;
+    uint32_t monkeys = 8;
+} gen_options_s;
+
+/*
+std::mt19937_64 output is fully specified by the standard, the distributions are not,
+so the ranges are derived by hand to keep the output identical across standard libraries
+*/
+class Random
+{
+private:
+    mt19937_64 engine;
+public:
+    Random(uint64_t seed) : engine(seed) {}
+    uint64_t below(uint64_t limit) { return engine() % limit; }
+    int64_t between(int64_t low, int64_t high) { return low + static_cast<int64_t>(below(high - low + 1)); }
+    template <typename T>
+    void shuffle(T& items)
+    {
+        for(size_t i = items.size(); i > 1; i--)
+        {
+            swap(items[i - 1], items[below(i)]);
+        }
+    }
+};
+
+/*
+buffers the output and flushes it in big writes
+*/
+class Writer
+{
+private:
+    FILE* file;
+    string buffer;
+    uint64_t written = 0;
+public:
+    Writer(FILE* file) : file(file) { buffer.reserve(1 << 20); }
+    ~Writer() { flush(); }
+    void flush()
+    {
+        if(file) // a writer without a file only counts the bytes
+            fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+    Writer& operator<<(const string& str)
+    {
+        buffer += str;
+        written += str.size();
+        if(buffer.size() >= (1 << 20))
+            flush();
+        return *this;
+    }
+    Writer& operator<<(char ch) { return *this << string(1, ch); }
+    Writer& operator<<(int64_t value) { return *this << to_string(value); }
+    uint64_t size() const { return written; }
+};
+
+char item_letter(uint32_t index) // 0-25 -> a-z, 26-51 -> A-Z
+{
+    return (index < 26) ? static_cast<char>('a' + index) : static_cast<char>('A' + index - 26);
+}
+
+void gen_calories(Writer& out, Random& rng, const gen_options_s& options)
+{
+    while(out.size() < options.size)
+    {
+        int64_t items = rng.between(1, 15);
+        for(int64_t i = 0; i < items; i++)
+            out << rng.between(1000, 60000) << '\n';
+        out << '\n';
+    }
+}
+
+void gen_rps(Writer& out, Random& rng, const gen_options_s& options)
+{
+    while(out.size() < options.size)
+    {
+        out << static_cast<char>('A' + rng.below(3)) << ' ' << static_cast<char>('X' + rng.below(3)) << '\n';
+    }
+}
+
+/*
+every line of a group draws its items from its own pool (a third of the letters),
+so the only item the 3 lines share is the badge, and the halves of a line draw
+from 2 disjoint parts of the pool, so the only item they share is the common one
+*/
+void gen_rucksacks(Writer& out, Random& rng, const gen_options_s& options)
+{
+    while(out.size() < options.size)
+    {
+        vector<uint32_t> letters(52);
+        for(uint32_t i = 0; i < 52; i++)
+            letters[i] = i;
+        rng.shuffle(letters);
+        uint32_t badge = letters[51];
+        for(uint32_t line = 0; line < 3; line++)
+        {
+            vector<uint32_t> pool(letters.begin() + line * 17, letters.begin() + (line + 1) * 17);
+            uint32_t common = pool[16];
+            uint32_t half_length = rng.between(4, 16);
+            bool is_badge_in_first = rng.below(2);
+            string halves[2];
+            for(uint32_t half = 0; half < 2; half++)
+            {
+                halves[half] += item_letter(common);
+                if(is_badge_in_first == (half == 0))
+                    halves[half] += item_letter(badge);
+                while(halves[half].size() < half_length)
+                    halves[half] += item_letter(pool[half * 8 + rng.below(8)]);
+                rng.shuffle(halves[half]);
+            }
+            out << halves[0] << halves[1] << '\n';
+        }
+    }
+}
+
+void gen_ranges(Writer& out, Random& rng, const gen_options_s& options)
+{
+    while(out.size() < options.size)
+    {
+        int64_t first_begin = rng.between(1, 99), second_begin = rng.between(1, 99);
+        out << first_begin << '-' << rng.between(first_begin, 99) << ','
+            << second_begin << '-' << rng.between(second_begin, 99) << '\n';
+    }
+}
+
+void gen_marker(Writer& out, Random& rng, const gen_options_s& options)
+{
+    // 3 letters can never make a window of 4 distinct characters
+    string body;
+    uint64_t body_size = (options.size > 32) ? options.size - 15 : 16; // the markers and the newline make it exactly size
+    while(out.size() < body_size)
+    {
+        body.clear();
+        for(uint32_t i = 0; i < 4096 && out.size() + body.size() < body_size; i++)
+            body += static_cast<char>('a' + rng.below(3));
+        out << body;
+    }
+    out << string("defghijklmnopq") << '\n'; // 14 distinct characters
+}
+
+/*
+the used space of a valid transcript is above DISK_SIZE - UPDATE_SIZE of task_7 (the update needs
+a folder deleted) and at most DISK_SIZE, so the file sizes share a budget drawn inside that range.
+a first pass that only counts bytes fixes the number of trees and files (with the digits of the
+mean file size), then every file gets a random share of what is left of the budget, the last one all of it.
+the shape and the sizes come from two generators, so both passes draw the same trees.
+*/
+const int64_t TRANSCRIPT_DISK_SIZE = 70000000;
+const int64_t TRANSCRIPT_UPDATE_SIZE = 30000000;
+
+typedef struct
+{
+    Random* rng;        // nullptr while counting, every file is then mean_size
+    int64_t mean_size;
+    uint64_t files = 0;  // files written so far
+    uint64_t files_left = 0;
+    int64_t budget_left = 0;
+} transcript_sizes_s;
+
+int64_t next_file_size(transcript_sizes_s& sizes)
+{
+    sizes.files++;
+    if(!sizes.rng)
+        return sizes.mean_size;
+    sizes.files_left--;
+    int64_t size = sizes.budget_left; // the last file takes the rest
+    if(sizes.files_left > 0)
+    {
+        int64_t mean = sizes.budget_left / static_cast<int64_t>(sizes.files_left + 1);
+        size = sizes.rng->between(max<int64_t>(1, mean / 2), max<int64_t>(1, mean + mean / 2));
+        size = min(size, sizes.budget_left - static_cast<int64_t>(sizes.files_left)); // at least 1 for every other file
+    }
+    size = max<int64_t>(1, size);
+    sizes.budget_left -= size;
+    return size;
+}
+
+void gen_transcript_dir(Writer& out, Random& rng, transcript_sizes_s& sizes, const gen_options_s& options, uint32_t depth)
+{
+    out << string("$ ls\n");
+    uint32_t num_files = rng.between(1, 4);
+    uint32_t num_dirs = (depth < options.depth) ? options.fanout : 0;
+    for(uint32_t i = 0; i < num_dirs; i++)
+        out << string("dir d") << static_cast<int64_t>(i) << '\n';
+    for(uint32_t i = 0; i < num_files; i++)
+        out << next_file_size(sizes) << string(" f") << static_cast<int64_t>(i) << string(".txt\n");
+    for(uint32_t i = 0; i < num_dirs; i++)
+    {
+        out << string("$ cd d") << static_cast<int64_t>(i) << '\n';
+        gen_transcript_dir(out, rng, sizes, options, depth + 1);
+        out << string("$ cd ..\n");
+    }
+}
+
+// writes trees until the size is reached (num_trees == 0) or num_trees of them, returns how many
+int64_t gen_transcript_trees(Writer& out, Random& rng, transcript_sizes_s& sizes, const gen_options_s& options, int64_t num_trees)
+{
+    int64_t tree = 0;
+    for(; num_trees ? tree < num_trees : out.size() < options.size; tree++)
+    {
+        out << string("$ cd /\n$ ls\ndir t") << tree << '\n';
+        out << string("$ cd t") << tree << '\n';
+        gen_transcript_dir(out, rng, sizes, options, 1);
+    }
+    return tree;
+}
+
+void gen_transcript(Writer& out, Random& rng, const gen_options_s& options)
+{
+    Random size_rng(rng.below(UINT64_MAX));
+    Random shape_rng = rng;
+    int64_t budget = size_rng.between(TRANSCRIPT_DISK_SIZE - TRANSCRIPT_UPDATE_SIZE + 5000000, TRANSCRIPT_DISK_SIZE - 5000000);
+
+    // twice: the mean file size of the first count sets the length of the size column of the second one
+    int64_t num_trees = 0;
+    transcript_sizes_s sizes = {nullptr, 100000};
+    for(int count = 0; count < 2; count++)
+    {
+        Writer counter(nullptr);
+        Random count_rng = shape_rng;
+        sizes.files = 0;
+        num_trees = gen_transcript_trees(counter, count_rng, sizes, options, 0);
+        sizes.mean_size = max<int64_t>(1, budget / static_cast<int64_t>(sizes.files));
+    }
+    if(static_cast<int64_t>(sizes.files) > budget)
+    {
+        throw runtime_error("gen_transcript(): " + to_string(sizes.files) + " files do not fit a disk of " +
+                            to_string(TRANSCRIPT_DISK_SIZE) + ", ask for a smaller size");
+    }
+
+    sizes = {&size_rng, 0, 0, sizes.files, budget};
+    gen_transcript_trees(out, shape_rng, sizes, options, num_trees);
+    int64_t used = budget - sizes.budget_left;
+    if(used <= TRANSCRIPT_DISK_SIZE - TRANSCRIPT_UPDATE_SIZE || used > TRANSCRIPT_DISK_SIZE)
+    {
+        throw runtime_error("gen_transcript(): the files take " + to_string(used) + " bytes, outside of the task_7 disk");
+    }
+}
+
+void gen_grid(Writer& out, Random& rng, const gen_options_s& options)
+{
+    string row;
+    for(uint32_t r = 0; r < options.rows; r++)
+    {
+        row.clear();
+        for(uint32_t c = 0; c < options.cols; c++)
+            row += static_cast<char>('0' + rng.below(10));
+        out << row << '\n';
+    }
+}
+
+void gen_rope(Writer& out, Random& rng, const gen_options_s& options)
+{
+    const char directions[] = {'U', 'D', 'L', 'R'};
+    while(out.size() < options.size)
+    {
+        out << directions[rng.below(4)] << ' ' << rng.between(1, 20) << '\n';
+    }
+}
+
+void gen_cpu(Writer& out, Random& rng, const gen_options_s& options)
+{
+    int64_t x_register = 1;
+    while(out.size() < options.size)
+    {
+        if(rng.below(3) == 0)
+        {
+            out << string("noop\n");
+            continue;
+        }
+        // keep the sprite on the 40 pixel wide screen
+        int64_t value = rng.between(-10, 10);
+        if(x_register + value < 0 || x_register + value > 39)
+            value = -value;
+        x_register += value;
+        out << string("addx ") << value << '\n';
+    }
+}
+
+void gen_monkeys(Writer& out, Random& rng, const gen_options_s& options)
+{
+    const int64_t primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23};
+    uint32_t num_monkeys = max<uint32_t>(options.monkeys, 2);
+    for(uint32_t id = 0; id < num_monkeys; id++)
+    {
+        out << string("Monkey ") << static_cast<int64_t>(id) << string(":\n  Starting items: ");
+        int64_t num_items = rng.between(1, 6);
+        for(int64_t i = 0; i < num_items; i++)
+            out << string(i ? ", " : "") << rng.between(50, 99);
+        out << string("\n  Operation: new = old ");
+        switch(rng.below(3))
+        {
+            case 0:  out << string("* ") << rng.between(2, 19); break;
+            case 1:  out << string("+ ") << rng.between(1, 8); break;
+            default: out << string("* old"); break;
+        }
+        uint32_t on_true = (id + 1 + rng.below(num_monkeys - 1)) % num_monkeys;
+        uint32_t on_false = (id + 1 + rng.below(num_monkeys - 1)) % num_monkeys;
+        out << string("\n  Test: divisible by ") << primes[id % 9]
+            << string("\n    If true: throw to monkey ") << static_cast<int64_t>(on_true)
+            << string("\n    If false: throw to monkey ") << static_cast<int64_t>(on_false) << '\n';
+        if(id + 1 < num_monkeys)
+            out << '\n';
+    }
+}
+
+const map<string, function<void(Writer&, Random&, const gen_options_s&)>> GENERATORS =
+{
+    {"task_1", gen_calories},
+    {"task_2", gen_rps},
+    {"task_3", gen_rucksacks},
+    {"task_4", gen_ranges},
+    {"task_6", gen_marker},
+    {"task_7", gen_transcript},
+    {"task_8", gen_grid},
+    {"task_9", gen_rope},
+    {"task_10", gen_cpu},
+    {"task_11", gen_monkeys},
+};
+
+int usage(const char* name)
+{
+    cerr << "usage: " << name << " <day> [--size BYTES] [--seed N] [--out PATH] [--rows N --cols N] [--depth N --fanout N] [--monkeys N]" << endl;
+    cerr << "days:";
+    for(const auto& generator : GENERATORS)
+        cerr << " " << generator.first;
+    cerr << endl;
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2 || GENERATORS.find(argv[1]) == GENERATORS.end())
+        return usage(argv[0]);
+
+    gen_options_s options;
+    for(int i = 2; i < argc; i += 2)
+    {
+        if(i + 1 >= argc)
+            return usage(argv[0]);
+        string flag = argv[i], value = argv[i + 1];
+        if(flag == "--size")
+            options.size = stoull(value);
+        else if(flag == "--seed")
+            options.seed = stoull(value);
+        else if(flag == "--out")
+            options.out_path = value;
+        else if(flag == "--rows")
+            options.rows = stoul(value);
+        else if(flag == "--cols")
+            options.cols = stoul(value);
+        else if(flag == "--depth")
+            options.depth = stoul(value);
+        else if(flag == "--fanout")
+            options.fanout = stoul(value);
+        else if(flag == "--monkeys")
+            options.monkeys = stoul(value);
+        else
+            return usage(argv[0]);
+    }
+
+    FILE* file = options.out_path.empty() ? stdout : fopen(options.out_path.c_str(), "wb");
+    if(!file)
+    {
+        cerr << "failed to open " << options.out_path << endl;
+        return 1;
+    }
+    bool is_ok = true;
+    {
+        Writer out(file);
+        Random rng(options.seed);
+        try
+        {
+            GENERATORS.at(argv[1])(out, rng, options);
+        }
+        catch(const exception& e)
+        {
+            cerr << e.what() << endl;
+            is_ok = false;
+        }
+    }
+    if(file != stdout)
+        fclose(file);
+    return is_ok ? 0 : 1;
+}
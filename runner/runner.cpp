@@ -0,0 +1,216 @@
+/*
+runs any subset of the days in one process, concurrently on a thread pool
+
+every job is one day on one input: parse, part 1 and part 2 run on the same worker thread
+and are timed separately, the results are printed in order once every job is done.
+the days are linked in through their solver_t (utils/solver.h), task_11 has no solver yet.
+
+usage: runner [--days task_1,task_7] [--threads N] [--roots DIR1,DIR2]
+the input of a day is <root>/<day>/input.txt, the default root is the current directory,
+several roots run every selected day on every root (batch validation of inputs).
+the exit code is 1 if any job failed.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../utils/solver.h"
+#include "../utils/thread_pool.h"
+
+using namespace std;
+
+extern "C"
+{
+extern const solver_t task_1_solver;
+extern const solver_t task_2_solver;
+extern const solver_t task_3_solver;
+extern const solver_t task_4_solver;
+extern const solver_t task_6_solver;
+extern const solver_t task_7_solver;
+extern const solver_t task_8_solver;
+extern const solver_t task_9_solver;
+extern const solver_t task_10_solver;
+}
+
+const vector<const solver_t*> SOLVERS =
+{
+    &task_1_solver,
+    &task_2_solver,
+    &task_3_solver,
+    &task_4_solver,
+    &task_6_solver,
+    &task_7_solver,
+    &task_8_solver,
+    &task_9_solver,
+    &task_10_solver,
+};
+
+typedef struct
+{
+    const solver_t* solver;
+    string input_path;
+} job_s;
+
+typedef struct
+{
+    bool is_ok = false;
+    string error;
+    double parse_ms = 0;
+    double part_ms[2] = {0, 0};
+    string answers[2];
+} job_result_s;
+
+vector<string> split(const string& str, char sep)
+{
+    vector<string> result;
+    stringstream stream(str);
+    string item;
+    while(getline(stream, item, sep))
+    {
+        if(!item.empty())
+            result.push_back(item);
+    }
+    return result;
+}
+
+double elapsed_ms(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+job_result_s run_job(const job_s& job)
+{
+    job_result_s result;
+    auto start = chrono::steady_clock::now();
+    void* state = job.solver->parse(job.input_path.c_str());
+    result.parse_ms = elapsed_ms(start);
+    if(!state)
+    {
+        result.error = "failed to parse " + job.input_path;
+        return result;
+    }
+    bool (*const parts[2])(void*, char*, size_t) = {job.solver->part1, job.solver->part2};
+    result.is_ok = true;
+    for(int part = 0; part < 2; part++)
+    {
+        char answer[SOLVER_ANSWER_SIZE] = {0};
+        start = chrono::steady_clock::now();
+        bool is_part_ok = parts[part](state, answer, sizeof(answer));
+        result.part_ms[part] = elapsed_ms(start);
+        if(!is_part_ok)
+        {
+            result.is_ok = false;
+            result.error = "part " + to_string(part + 1) + " failed";
+            break;
+        }
+        result.answers[part] = answer;
+    }
+    job.solver->release(state);
+    return result;
+}
+
+void print_result(const job_s& job, const job_result_s& result)
+{
+    char timing[160];
+    snprintf(timing, sizeof(timing), "parse %9.3f ms   part 1 %9.3f ms   part 2 %9.3f ms",
+             result.parse_ms, result.part_ms[0], result.part_ms[1]);
+    cout << job.solver->name << " (" << job.input_path << "): " << timing << endl;
+    for(int part = 0; part < 2; part++)
+    {
+        if(result.answers[part].empty())
+            continue;
+        // multi line answers (task_10 screen) are indented under their part
+        string answer = result.answers[part];
+        for(size_t pos = answer.find('\n'); pos != string::npos; pos = answer.find('\n', pos + 1))
+            answer.replace(pos, 1, "\n          ");
+        cout << "  part " << part + 1 << ": " << answer << endl;
+    }
+    if(!result.is_ok)
+        cout << "  error: " << result.error << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> selected_days, roots = {"."};
+    size_t num_threads = 0;
+
+    for(int i = 1; i < argc; i += 2)
+    {
+        if(i + 1 >= argc)
+        {
+            cerr << "usage: " << argv[0] << " [--days task_1,task_7] [--threads N] [--roots DIR1,DIR2]" << endl;
+            return 1;
+        }
+        string flag = argv[i], value = argv[i + 1];
+        if(flag == "--days")
+            selected_days = split(value, ',');
+        else if(flag == "--threads")
+            num_threads = stoul(value);
+        else if(flag == "--roots")
+            roots = split(value, ',');
+        else
+        {
+            cerr << "unknown flag " << flag << endl;
+            return 1;
+        }
+    }
+    for(const string& day : selected_days)
+    {
+        auto is_named = [&day](const solver_t* solver) { return day == solver->name; };
+        if(find_if(SOLVERS.begin(), SOLVERS.end(), is_named) == SOLVERS.end())
+        {
+            cerr << "no solver for " << day << endl;
+            return 1;
+        }
+    }
+
+    vector<job_s> jobs;
+    for(const string& root : roots)
+    {
+        for(const solver_t* solver : SOLVERS)
+        {
+            if(selected_days.empty() || find(selected_days.begin(), selected_days.end(), solver->name) != selected_days.end())
+                jobs.push_back({solver, root + "/" + solver->name + "/input.txt"});
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<job_result_s> results(jobs.size());
+    size_t pool_size = 0;
+    {
+        ThreadPool pool(num_threads);
+        pool_size = pool.size();
+        vector<future<job_result_s>> futures;
+        for(const job_s& job : jobs)
+            futures.push_back(pool.submit([&job] { return run_job(job); }));
+        for(size_t i = 0; i < jobs.size(); i++)
+        {
+            try
+            {
+                results[i] = futures[i].get();
+            }
+            catch(const exception& e)
+            {
+                results[i].error = e.what();
+            }
+        }
+    }
+    double total_ms = elapsed_ms(start);
+
+    bool is_all_ok = true;
+    for(size_t i = 0; i < jobs.size(); i++)
+    {
+        print_result(jobs[i], results[i]);
+        is_all_ok = is_all_ok && results[i].is_ok;
+    }
+    printf("%zu jobs on %zu threads in %.3f ms\n", jobs.size(), pool_size, total_ms);
+    return is_all_ok ? 0 : 1;
+}
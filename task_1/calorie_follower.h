@@ -0,0 +1,198 @@
+#ifndef CALORIE_FOLLOWER_H
+#define CALORIE_FOLLOWER_H
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../utils/scanner.h"
+#include "../utils/parse_int.h"
+#include "top_k.h"
+
+struct CalorieFollowerError : public std::runtime_error
+{
+    bool is_missing; // the file does not exist (yet, or while it is replaced)
+    CalorieFollowerError(const std::string& msg, bool is_missing = false) : std::runtime_error(msg), is_missing(is_missing) {}
+};
+
+/*
+incremental top-K over a calorie file that keeps growing
+
+the follower remembers how far it got (the offset of the first line it has not finished),
+the sum of the group in progress and the top-K of the closed groups, so an update reads
+and parses only the appended bytes. a line without its newline yet is left for the next update.
+the answers count the group in progress, so they match a full run on the complete lines written so far.
+a file that shrank (truncated or replaced) is followed again from the start.
+*/
+class CalorieFollower
+{
+private:
+    std::string m_path;
+    size_t m_k;
+    uint64_t m_offset = 0;
+    uint64_t m_group_sum = 0;
+    TopK m_top_k;
+    std::vector<char> m_buffer;
+
+    void reset()
+    {
+        m_offset = 0;
+        m_group_sum = 0;
+        m_top_k = TopK(m_k);
+    }
+
+    // consume the complete lines of buf, returns the number of bytes consumed
+    size_t consume(const char* buf, size_t length)
+    {
+        size_t pos = 0;
+        while(pos < length)
+        {
+            size_t line_length = scan_find_char(buf + pos, length - pos, '\n');
+            if(pos + line_length == length)
+                break; // no newline yet
+            std::string_view line(buf + pos, line_length);
+            if(line.length())
+            {
+                m_group_sum += parse_number<uint32_t>(line);
+            }
+            else
+            {
+                m_top_k.push(m_group_sum);
+                m_group_sum = 0;
+            }
+            pos += line_length + 1;
+        }
+        return pos;
+    }
+public:
+    explicit CalorieFollower(std::string path, size_t k = 3, size_t buffer_size = 1 << 20)
+        : m_path(std::move(path)), m_k(k), m_top_k(k), m_buffer(buffer_size) {}
+
+    const std::string& path() const { return m_path; }
+
+    /*
+    process what was appended since the last update
+    returns true if the answers may have changed
+    throws CalorieFollowerError if the file can not be read, std::invalid_argument on an invalid number
+    */
+    bool update()
+    {
+        int fd = open(m_path.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            throw CalorieFollowerError("failed to open " + m_path, errno == ENOENT);
+        }
+        struct stat file_stat;
+        if(fstat(fd, &file_stat) != 0)
+        {
+            close(fd);
+            throw CalorieFollowerError("failed to stat " + m_path);
+        }
+        bool is_changed = false;
+        if(static_cast<uint64_t>(file_stat.st_size) < m_offset)
+        {
+            reset();
+            is_changed = true;
+        }
+        size_t pending = 0; // bytes of an unfinished line at the start of the buffer
+        while(true)
+        {
+            ssize_t bytes_read = pread(fd, m_buffer.data() + pending, m_buffer.size() - pending, m_offset + pending);
+            if(bytes_read < 0)
+            {
+                close(fd);
+                throw CalorieFollowerError("failed to read " + m_path);
+            }
+            if(bytes_read == 0)
+                break;
+            size_t available = pending + bytes_read;
+            size_t consumed = consume(m_buffer.data(), available);
+            is_changed = is_changed || consumed > 0;
+            m_offset += consumed;
+            pending = available - consumed;
+            if(pending == m_buffer.size()) // a single line bigger than the buffer
+            {
+                m_buffer.resize(m_buffer.size() * 2);
+            }
+            else if(consumed > 0 && pending > 0)
+            {
+                std::copy(m_buffer.begin() + consumed, m_buffer.begin() + available, m_buffer.begin());
+            }
+        }
+        close(fd);
+        return is_changed;
+    }
+
+    // the K biggest group sums so far, the group in progress included
+    std::vector<uint64_t> top_values() const
+    {
+        TopK current = m_top_k;
+        current.push(m_group_sum);
+        return current.values();
+    }
+
+    uint64_t top_sum(size_t count) const
+    {
+        std::vector<uint64_t> values = top_values();
+        uint64_t total = 0;
+        for(size_t i = 0; i < count && i < values.size(); i++)
+            total += values[i];
+        return total;
+    }
+};
+
+/*
+blocks until the file at path may have changed or interval_ms passed
+inotify is used when the kernel allows it, otherwise (and as a safety net for missed events) it polls
+*/
+class FileChangeWaiter
+{
+private:
+    int m_inotify_fd = -1;
+    std::vector<char> m_events;
+public:
+    FileChangeWaiter(const std::string& path) : m_events(4096)
+    {
+        m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(m_inotify_fd >= 0 && inotify_add_watch(m_inotify_fd, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB) < 0)
+        {
+            close(m_inotify_fd);
+            m_inotify_fd = -1;
+        }
+    }
+    ~FileChangeWaiter()
+    {
+        if(m_inotify_fd >= 0)
+            close(m_inotify_fd);
+    }
+    FileChangeWaiter(const FileChangeWaiter&) = delete;
+    FileChangeWaiter& operator=(const FileChangeWaiter&) = delete;
+
+    bool is_using_inotify() const { return m_inotify_fd >= 0; }
+
+    void wait(int interval_ms)
+    {
+        if(m_inotify_fd < 0)
+        {
+            usleep(interval_ms * 1000);
+            return;
+        }
+        struct pollfd poll_fd = {m_inotify_fd, POLLIN, 0};
+        if(poll(&poll_fd, 1, interval_ms) > 0)
+        {
+            // drain the events, the follower reads the file anyway
+            while(read(m_inotify_fd, m_events.data(), m_events.size()) > 0) {}
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef CALORIE_KERNEL_H
+#define CALORIE_KERNEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "../utils/scanner.h"
+#include "../utils/parse_int.h"
+#include "top_k.h"
+
+/*
+vectorized summation of the calorie format straight from the raw (mapped) buffer
+
+the buffer is consumed 64 bytes at a time: the newlines of a block become a 64-bit mask
+(2 AVX2 or 4 SSE2 compares), and the lines are walked with count-trailing-zeros.
+a line of 1-8 digits is converted in a single register (swar_digits_value), an empty
+line closes the current group. nothing is allocated and no per-line object is built.
+the kernel is picked with the scanner's cpuid dispatch, with a scalar fallback.
+*/
+
+/*
+the sums of a range of whole lines, the groups at both edges of the range are left open
+so ranges can be summed independently and stitched in order afterwards
+*/
+typedef struct
+{
+    uint64_t first_sum; // lines before the first blank line, they continue the group of the previous range
+    uint64_t last_sum;  // lines after the last blank line, the next range may continue the group
+    bool has_separator; // at least one blank line in the range, otherwise the whole range is first_sum
+    TopK top_k;         // groups fully inside the range
+} chunk_sums_s;
+
+class CalorieAccumulator
+{
+private:
+    chunk_sums_s& m_sums;
+    uint64_t m_group_sum = 0;
+public:
+    explicit CalorieAccumulator(chunk_sums_s& sums) : m_sums(sums) {}
+
+    // [line, line + length) holds no newline, end is the end of the readable buffer
+    void add_line(const char* line, size_t length, const char* end)
+    {
+        if(length == 0)
+        {
+            close_group();
+            return;
+        }
+        if(length <= 8 && end - line >= 8)
+        {
+            uint64_t chunk;
+            memcpy(&chunk, line, sizeof(chunk));
+            if(swar_count_digits(chunk) >= length)
+            {
+                m_group_sum += swar_digits_value(chunk, static_cast<uint32_t>(length));
+                return;
+            }
+        }
+        // long numbers, the last bytes of the buffer, and invalid lines (which throw)
+        m_group_sum += parse_number<uint32_t>(std::string_view(line, length));
+    }
+
+    void close_group()
+    {
+        if(!m_sums.has_separator)
+        {
+            m_sums.first_sum = m_group_sum;
+            m_sums.has_separator = true;
+        }
+        else
+        {
+            m_sums.top_k.push(m_group_sum);
+        }
+        m_group_sum = 0;
+    }
+
+    void finish()
+    {
+        if(m_sums.has_separator)
+            m_sums.last_sum = m_group_sum;
+        else
+            m_sums.first_sum = m_group_sum;
+    }
+};
+
+/*
+every set bit of mask is a newline at block + bit, line_start is carried from block to block
+*/
+static inline void calorie_walk_mask(const char* block, uint64_t mask, const char*& line_start, const char* end,
+                                     CalorieAccumulator& accumulator)
+{
+    while(mask)
+    {
+        const char* newline = block + __builtin_ctzll(mask);
+        accumulator.add_line(line_start, newline - line_start, end);
+        line_start = newline + 1;
+        mask &= mask - 1;
+    }
+}
+
+static inline const char* calorie_sum_scalar(const char* pos, const char* stop, const char* line_start,
+                                             const char* end, CalorieAccumulator& accumulator)
+{
+    while(pos < stop)
+    {
+        const char* newline = pos + scan_find_char_scalar(pos, stop - pos, '\n');
+        if(newline == stop)
+            break;
+        accumulator.add_line(line_start, newline - line_start, end);
+        line_start = pos = newline + 1;
+    }
+    return line_start;
+}
+
+#ifdef SCANNER_X86
+
+SCANNER_TARGET("sse2")
+static inline const char* calorie_sum_sse2(const char* pos, const char* stop, const char* end, CalorieAccumulator& accumulator)
+{
+    const __m128i newline_vec = _mm_set1_epi8('\n');
+    const char* line_start = pos;
+    for(; pos + 64 <= stop; pos += 64)
+    {
+        uint64_t mask = 0;
+        for(int i = 0; i < 4; i++)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos + 16 * i));
+            mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline_vec)))) << (16 * i);
+        }
+        calorie_walk_mask(pos, mask, line_start, end, accumulator);
+    }
+    return calorie_sum_scalar(pos, stop, line_start, end, accumulator);
+}
+
+SCANNER_TARGET("avx2")
+static inline const char* calorie_sum_avx2(const char* pos, const char* stop, const char* end, CalorieAccumulator& accumulator)
+{
+    const __m256i newline_vec = _mm256_set1_epi8('\n');
+    const char* line_start = pos;
+    for(; pos + 64 <= stop; pos += 64)
+    {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos + 32));
+        uint64_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline_vec)))
+                      | (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline_vec)))) << 32);
+        calorie_walk_mask(pos, mask, line_start, end, accumulator);
+    }
+    return calorie_sum_scalar(pos, stop, line_start, end, accumulator);
+}
+
+#endif // SCANNER_X86
+
+/*
+sum the lines that start in [begin, end) of data (the line that straddles begin belongs to the
+previous range, the line that straddles end is finished), keeping the k biggest inner groups
+*/
+static inline chunk_sums_s calorie_sum_range(std::string_view data, size_t begin, size_t end, size_t k)
+{
+    chunk_sums_s sums = {0, 0, false, TopK(k)};
+    const char* data_end = data.data() + data.size();
+    if(begin > 0 && data[begin - 1] != '\n')
+        begin += scan_find_char(data.data() + begin, data.size() - begin, '\n') + 1;
+    if(end > 0 && end < data.size() && data[end - 1] != '\n')
+        end += scan_find_char(data.data() + end, data.size() - end, '\n') + 1;
+    end = std::min(end, data.size());
+
+    CalorieAccumulator accumulator(sums);
+    if(begin < end)
+    {
+        const char* pos = data.data() + begin;
+        const char* stop = data.data() + end;
+        const char* line_start;
+        switch(scan_detect_isa())
+        {
+#ifdef SCANNER_X86
+            case SCAN_ISA_AVX2:
+                line_start = calorie_sum_avx2(pos, stop, data_end, accumulator);
+                break;
+            case SCAN_ISA_SSE2:
+                line_start = calorie_sum_sse2(pos, stop, data_end, accumulator);
+                break;
+#endif
+            default:
+                line_start = calorie_sum_scalar(pos, stop, pos, data_end, accumulator);
+                break;
+        }
+        if(line_start < stop) // the last line of the file has no newline
+            accumulator.add_line(line_start, stop - line_start, data_end);
+    }
+    accumulator.finish();
+    return sums;
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef CALORIE_SUMMARY_H
+#define CALORIE_SUMMARY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "top_k.h"
+
+struct CalorieSummaryError : public std::runtime_error
+{
+    CalorieSummaryError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+/*
+everything the answers need from a shard of the input: its K biggest group sums,
+the number of groups and the sum of every group. a shard must hold whole groups.
+
+summaries are merged in any order and any number of times (the K biggest of a union
+are among the K biggest of every part), so shards can be summed by different processes
+or at different times, and only the small summary files are read back.
+merging summaries of different K keeps the smaller K, the rest is not known.
+
+the file is a fixed header and K uint64 values, native byte order (like the parse cache)
+*/
+class CalorieSummary
+{
+private:
+    typedef struct
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t k;
+        uint64_t num_groups;
+        uint64_t total;
+    } header_s;
+
+    static constexpr const char* MAGIC = "AOCTOPK";
+    static constexpr uint32_t VERSION = 1;
+
+    TopK m_top_k;
+    uint64_t m_num_groups = 0;
+    uint64_t m_total = 0;
+public:
+    explicit CalorieSummary(size_t k) : m_top_k(k) {}
+
+    size_t k() const { return m_top_k.k(); }
+    uint64_t num_groups() const { return m_num_groups; }
+    uint64_t total() const { return m_total; }
+    std::vector<uint64_t> values() const { return m_top_k.values(); }
+
+    void add_group(uint64_t sum)
+    {
+        m_top_k.push(sum);
+        m_num_groups++;
+        m_total += sum;
+    }
+
+    void merge(const CalorieSummary& other)
+    {
+        if(other.k() < k())
+        {
+            TopK top_k(other.k());
+            for(uint64_t value : values())
+                top_k.push(value);
+            m_top_k = top_k;
+        }
+        for(uint64_t value : other.values())
+            m_top_k.push(value);
+        m_num_groups += other.m_num_groups;
+        m_total += other.m_total;
+    }
+
+    // sum of the count biggest groups, count must not exceed K
+    uint64_t top_sum(size_t count) const
+    {
+        if(count > k())
+            throw std::out_of_range("CalorieSummary::top_sum(): the summary only keeps " + std::to_string(k()) + " values");
+        std::vector<uint64_t> top = values();
+        uint64_t sum = 0;
+        for(size_t i = 0; i < count; i++)
+            sum += top[i];
+        return sum;
+    }
+
+    void save(const std::string& path) const
+    {
+        header_s header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAGIC, strlen(MAGIC));
+        header.version = VERSION;
+        header.k = static_cast<uint32_t>(k());
+        header.num_groups = m_num_groups;
+        header.total = m_total;
+        std::vector<uint64_t> top = values();
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if(!file)
+            throw CalorieSummaryError("failed to open " + path);
+        bool is_written = fwrite(&header, sizeof(header), 1, file) == 1
+                          && (top.empty() || fwrite(top.data(), sizeof(uint64_t), top.size(), file) == top.size());
+        is_written = (fclose(file) == 0) && is_written;
+        if(!is_written)
+            throw CalorieSummaryError("failed to write " + path);
+    }
+
+    static CalorieSummary load(const std::string& path)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if(!file)
+            throw CalorieSummaryError("failed to open " + path);
+        header_s header;
+        if(fread(&header, sizeof(header), 1, file) != 1
+           || memcmp(header.magic, MAGIC, strlen(MAGIC) + 1) != 0
+           || header.version != VERSION)
+        {
+            fclose(file);
+            throw CalorieSummaryError(path + " is not a calorie summary");
+        }
+        // k comes from the file, it must account for the rest of it before anything is allocated
+        struct stat file_stat;
+        if(fstat(fileno(file), &file_stat) != 0
+           || static_cast<uint64_t>(file_stat.st_size) != sizeof(header) + uint64_t(header.k) * sizeof(uint64_t))
+        {
+            fclose(file);
+            throw CalorieSummaryError(path + " has " + std::to_string(header.k) + " values in its header but not in its size");
+        }
+        std::vector<uint64_t> top(header.k);
+        bool is_read = top.empty() || fread(top.data(), sizeof(uint64_t), top.size(), file) == top.size();
+        fclose(file);
+        if(!is_read)
+            throw CalorieSummaryError(path + " is truncated");
+
+        CalorieSummary summary(header.k);
+        for(uint64_t value : top)
+            summary.m_top_k.push(value);
+        summary.m_num_groups = header.num_groups;
+        summary.m_total = header.total;
+        return summary;
+    }
+};
+
+#endif
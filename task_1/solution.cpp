@@ -1,119 +1,381 @@
 
-#include <vector>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <iostream>
-#include <fstream>
+#include <future>
+#include <vector>
+
+#include "../utils/stream_reader.h"
+#include "../utils/line_ranges.h"
+#include "../utils/mapped_file.h"
+#include "../utils/scanner.h"
+#include "../utils/thread_pool.h"
+#include "../utils/parse_int.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
+#include "top_k.h"
+#include "calorie_kernel.h"
+#include "calorie_follower.h"
+#include "calorie_summary.h"
 
 using namespace std;
 
-uint32_t find_max(string file_path)
+/*
+sum of the K biggest group totals, in a single streaming pass and O(K) memory
+groups are separated by blank lines, the last group does not need a blank line after it
+*/
+uint64_t find_max_k(string file_path, size_t k)
 {
-    fstream fp;
-    fp.open(file_path, ios::in);
-    uint32_t temp_num = 0, temp_sum = 0,  max_sum = 0;
-    string str;
-    while(getline(fp, str))
+    StreamReader fp(file_path);
+    TopK top_k(k);
+    uint64_t temp_sum = 0;
+    bool is_in_group = false;
+    string_view str;
+    while(fp.next_line(str))
     {
         if(str.length())
         {
-            temp_num = stoi(str);
-            temp_sum += temp_num;
+            temp_sum += parse_number<uint32_t>(str);
+            is_in_group = true;
         }
         else
         {
-            if(temp_sum > max_sum)
-            {
-                max_sum = temp_sum;
-            }
+            top_k.push(temp_sum);
             temp_sum = 0;
+            is_in_group = false;
         }
     }
-    return max_sum;
+    if(is_in_group)
+    {
+        top_k.push(temp_sum);
+    }
+    return top_k.sum();
 }
 
-void item_swap(vector<uint32_t> &vec, uint32_t first_index, uint32_t second_index)
+/*
+parallel mode: the mapped file is cut into one byte range per worker, a worker owns the lines
+that start in its range. groups can cross the edges of the ranges, so a worker only ranks the
+groups that start and end inside its range, and hands back the partial sums at both edges
+(chunk_sums_s, calorie_kernel.h).
+*/
+chunk_sums_s sum_chunk(string_view data, size_t begin, size_t end, size_t k)
 {
-    uint32_t len = vec.size();
-    if(first_index >= len || first_index < 0 || second_index >= len || second_index < 0)
+    chunk_sums_s result = {0, 0, false, TopK(k)};
+    size_t pos = begin;
+    if(pos > 0 && data[pos - 1] != '\n') // the line that starts before the range belongs to the previous worker
+    {
+        pos += scan_find_char(data.data() + pos, data.size() - pos, '\n') + 1;
+    }
+    uint64_t temp_sum = 0;
+    while(pos < end && pos < data.size())
     {
-        cout << "swap(): input indexes are not in range of vector" << endl;
+        size_t line_end = pos + scan_find_char(data.data() + pos, data.size() - pos, '\n');
+        string_view line = data.substr(pos, line_end - pos);
+        if(line.length())
+        {
+            temp_sum += parse_number<uint32_t>(line);
+        }
+        else if(!result.has_separator)
+        {
+            result.first_sum = temp_sum;
+            result.has_separator = true;
+            temp_sum = 0;
+        }
+        else
+        {
+            result.top_k.push(temp_sum);
+            temp_sum = 0;
+        }
+        pos = line_end + 1;
     }
-    uint32_t temp = vec.at(first_index);
-    vec.at(first_index) = vec.at(second_index);
-    vec.at(second_index) = temp;
+    if(result.has_separator)
+        result.last_sum = temp_sum;
+    else
+        result.first_sum = temp_sum;
+    return result;
+}
+
+/*
+add the sums of the next range (in file order) to top_k, open_group_sum carries the group
+that crosses the edge between the ranges. a zero push (empty group) never changes the top K
+*/
+void stitch_chunk(TopK& top_k, uint64_t& open_group_sum, const chunk_sums_s& chunk)
+{
+    if(!chunk.has_separator)
+    {
+        open_group_sum += chunk.first_sum;
+        return;
+    }
+    top_k.push(open_group_sum + chunk.first_sum);
+    for(uint64_t value : chunk.top_k.values())
+        top_k.push(value);
+    open_group_sum = chunk.last_sum;
+}
+
+/*
+find_max_k() on the vectorized kernel, the whole mapped file is a single range
+*/
+uint64_t find_max_k_simd(string file_path, size_t k)
+{
+    MappedFile file(file_path);
+    TopK top_k(k);
+    uint64_t open_group_sum = 0;
+    stitch_chunk(top_k, open_group_sum, calorie_sum_range(file.data(), 0, file.size(), k));
+    top_k.push(open_group_sum);
+    return top_k.sum();
+}
+
+/*
+same result as find_max_k(), num_threads 0 means one worker per hardware thread,
+use_simd sums every range with the vectorized kernel instead of line by line
+*/
+uint64_t find_max_k_parallel(string file_path, size_t k, size_t num_threads, bool use_simd)
+{
+    MappedFile file(file_path);
+    string_view data = file.data();
+    ThreadPool pool(num_threads);
+    size_t num_chunks = count_line_ranges(data.size(), pool);
+    size_t chunk_size = (data.size() + num_chunks - 1) / num_chunks;
+
+    vector<future<chunk_sums_s>> chunks;
+    for(size_t i = 0; i < num_chunks; i++)
+    {
+        size_t begin = i * chunk_size, end = min(data.size(), begin + chunk_size);
+        chunks.push_back(pool.submit([data, begin, end, k, use_simd] {
+            return use_simd ? calorie_sum_range(data, begin, end, k) : sum_chunk(data, begin, end, k);
+        }));
+    }
+
+    TopK top_k(k);
+    uint64_t open_group_sum = 0;
+    for(future<chunk_sums_s>& chunk : chunks)
+        stitch_chunk(top_k, open_group_sum, chunk.get());
+    top_k.push(open_group_sum);
+    return top_k.sum();
+}
+
+typedef struct
+{
+    size_t num_threads = 1; // 1 is the plain streaming pass
+    bool use_simd = false;
+} run_options_s;
+
+uint64_t find_max_k(string file_path, size_t k, const run_options_s& options)
+{
+    if(options.num_threads != 1)
+        return find_max_k_parallel(file_path, k, options.num_threads, options.use_simd);
+    return options.use_simd ? find_max_k_simd(file_path, k) : find_max_k(file_path, k);
+}
+
+uint64_t find_max(string file_path, const run_options_s& options = run_options_s())
+{
+    PERF_SCOPE("part 1: read+parse+solve"); // a single streaming pass
+    return find_max_k(file_path, 1, options);
+}
+
+uint64_t find_max_three(string file_path, const run_options_s& options = run_options_s())
+{
+    PERF_SCOPE("part 2: read+parse+solve");
+    return find_max_k(file_path, 3, options);
+}
+
+void sol1(const run_options_s& options)
+{
+    uint64_t max_sum = find_max("input.txt", options);
+    cout << max_sum << endl;
 }
 
-void max_sort(vector<uint32_t> &vec)
+void sol2(const run_options_s& options)
 {
-    uint32_t temp_max = 0, temp_max_index = -1, len = vec.size();
-    for(uint32_t i = 0; i < len; i++)
+    uint64_t max_sum = find_max_three("input.txt", options);
+    cout << max_sum << endl;
+}
+
+/*
+follow mode: keep the answers of a file that is still being written up to date,
+every update prints the answers again, it costs only the bytes appended since the previous one
+(calorie_follower.h). runs until it is killed, a missing file is waited for,
+returns 1 if the file can not be read or has an invalid number.
+*/
+int follow(string file_path, int part, int interval_ms)
+{
+    CalorieFollower follower(file_path, 3);
+    FileChangeWaiter waiter(file_path);
+    bool is_waiting = false; // the missing file was already reported
+    while(true)
     {
-        // find the max in [0: length - 1 - i] range
-        for(uint32_t j = 0; j + i < len; j++)
+        try
+        {
+            if(follower.update())
+            {
+                if(should_run_part(part, 1))
+                    cout << "part 1: " << follower.top_sum(1) << (part == PART_BOTH ? "  " : "");
+                if(should_run_part(part, 2))
+                    cout << "part 2: " << follower.top_sum(3);
+                cout << endl;
+            }
+            is_waiting = false;
+        }
+        catch(const CalorieFollowerError& e)
         {
-            if(vec.at(j) > temp_max)
+            if(!e.is_missing)
             {
-                temp_max = vec.at(j);
-                temp_max_index = j;
+                cerr << e.what() << endl;
+                return 1;
             }
+            if(!is_waiting)
+                cerr << file_path << " not found, waiting for it" << endl;
+            is_waiting = true;
         }
-        if(temp_max_index == -1)
+        catch(const invalid_argument& e)
         {
-            continue;
+            cerr << e.what() << endl;
+            return 1;
         }
-        // swap the max with index length - 1 - i
-        item_swap(vec, temp_max_index, len - i - 1);
-        // cleanup for next iteration
-        temp_max = 0;
-        temp_max_index = -1;
+        waiter.wait(interval_ms);
     }
 }
 
-uint32_t find_max_three(string file_path)
+/*
+sharded inputs: every shard (whole groups) is summed into a summary file on its own,
+the summaries are merged into the answers later (calorie_summary.h)
+*/
+const size_t SUMMARY_K = 3; // enough for both parts
+
+CalorieSummary summarize_shard(string file_path, size_t k)
 {
-    fstream fp;
-    fp.open(file_path, ios::in);
-    vector<uint32_t> sums;
-    string str;
-    uint32_t temp_num = 0, temp_sum = 0;
-    // create the array of sums
-    while(getline(fp, str))
+    StreamReader fp(file_path);
+    CalorieSummary summary(k);
+    uint64_t temp_sum = 0;
+    bool is_in_group = false;
+    string_view str;
+    while(fp.next_line(str))
     {
         if(str.length())
         {
-            temp_num = stoi(str);
-            temp_sum += temp_num;
+            temp_sum += parse_number<uint32_t>(str);
+            is_in_group = true;
         }
-        else
+        else if(is_in_group)
         {
-            sums.push_back(temp_sum);
+            summary.add_group(temp_sum);
             temp_sum = 0;
+            is_in_group = false;
         }
     }
-    // sort the array
-    max_sort(sums);
-    // return the sum of the max 3
-    temp_sum = 0;
-    for(uint32_t i = 0; i < 3; i++)
+    if(is_in_group)
     {
-        temp_sum += sums.at(sums.size() - 1 - i);
+        summary.add_group(temp_sum);
     }
-    return temp_sum;
+    return summary;
 }
 
-void sol1()
+void merge_summaries(const vector<string>& summary_paths, int part)
 {
-    uint32_t max_sum = find_max("input.txt");
-    cout << max_sum << endl;
+    CalorieSummary merged(SUMMARY_K);
+    for(const string& path : summary_paths)
+        merged.merge(CalorieSummary::load(path));
+    if(should_run_part(part, 1))
+        cout << merged.top_sum(1) << endl;
+    if(should_run_part(part, 2))
+        cout << merged.top_sum(3) << endl;
+    cerr << summary_paths.size() << " summaries, " << merged.num_groups() << " groups, "
+         << merged.total() << " calories in total" << endl;
 }
 
-void sol2()
+// the file is parsed once into the K biggest group sums, the parts only add them up
+static void* solver_parse(const char* input_path)
 {
-    uint32_t max_sum = find_max_three("input.txt");
-    cout << max_sum << endl;
+    return new CalorieSummary(summarize_shard(input_path, SUMMARY_K));
 }
 
-int main()
+static bool solver_part1(void* state, char* answer, size_t answer_size)
 {
-    sol2();
-}
\ No newline at end of file
+    return solver_answer_u64(answer, answer_size, static_cast<CalorieSummary*>(state)->top_sum(1));
+}
+
+static bool solver_part2(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, static_cast<CalorieSummary*>(state)->top_sum(3));
+}
+
+static void solver_release(void* state)
+{
+    delete static_cast<CalorieSummary*>(state);
+}
+
+extern "C" const solver_t task_1_solver = {"task_1", solver_parse, solver_part1, solver_part2, solver_release};
+
+#ifndef AOC_RUNNER
+int usage(const char* name)
+{
+    cerr << "usage: " << name << " [1|2] [--threads N] [--simd] [--follow [--interval MS]]" << endl
+         << "       " << name << " --summarize SHARD SUMMARY" << endl
+         << "       " << name << " [1|2] --merge SUMMARY..." << endl;
+    return 1;
+}
+
+/*
+solution [1|2] [--threads N] [--simd] [--follow [--interval MS]]
+--threads N   sums the file with N workers (0 = one per hardware thread), the default is a single streaming pass
+--simd        sums the mapped file with the vectorized kernel (calorie_kernel.h)
+--follow      keeps following input.txt as it grows and prints the answers after every change
+--interval MS the longest wait between two checks of the file in follow mode (default 200)
+
+solution --summarize SHARD SUMMARY   writes the summary of the shard file SHARD to SUMMARY
+solution [1|2] --merge SUMMARY...    prints the answers of all the shards from their summaries
+*/
+int main(int argc, char* argv[])
+{
+    bool has_part_arg = (argc > 1 && strncmp(argv[1], "--", 2) != 0);
+    int part = has_part_arg ? parse_part_arg(argc, argv) : PART_BOTH;
+    if(part == PART_INVALID)
+        return 1;
+    run_options_s options;
+    bool is_following = false;
+    int interval_ms = 200;
+    for(int i = has_part_arg ? 2 : 1; i < argc; i++)
+    {
+        bool is_summarizing = strcmp(argv[i], "--summarize") == 0 && i + 3 == argc && !has_part_arg;
+        bool is_merging = strcmp(argv[i], "--merge") == 0 && i + 1 < argc;
+        if(is_summarizing || is_merging)
+        {
+            try
+            {
+                if(is_summarizing)
+                    summarize_shard(argv[i + 1], SUMMARY_K).save(argv[i + 2]);
+                else
+                    merge_summaries(vector<string>(argv + i + 1, argv + argc), part);
+            }
+            catch(const exception& e)
+            {
+                // an unreadable shard or summary, an invalid number, or a summary with fewer than 3 values
+                cerr << e.what() << endl;
+                return 1;
+            }
+            return 0;
+        }
+        else if(strcmp(argv[i], "--simd") == 0)
+            options.use_simd = true;
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc && parse_int(string_view(argv[i + 1]), options.num_threads))
+            i++;
+        else if(strcmp(argv[i], "--follow") == 0)
+            is_following = true;
+        else if(strcmp(argv[i], "--interval") == 0 && i + 1 < argc && parse_int(string_view(argv[i + 1]), interval_ms) && interval_ms > 0)
+            i++;
+        else
+            return usage(argv[0]);
+    }
+    if(is_following)
+    {
+        return follow("input.txt", part, interval_ms);
+    }
+    if(should_run_part(part, 1))
+        sol1(options);
+    if(should_run_part(part, 2))
+        sol2(options);
+    PERF_REPORT();
+}
+#endif
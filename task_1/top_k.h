@@ -0,0 +1,103 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+/*
+keeps the K biggest values pushed so far in O(K) memory
+
+small K (up to SMALL_K) lives in a fixed array sorted ascending, a push that beats the
+minimum is inserted with a branchless pass over the array (no data dependent jumps, so
+a random stream of sums costs no branch misses).
+bigger K uses a min-heap, the root is the value to evict.
+slots that were never filled count as 0.
+*/
+class TopK
+{
+public:
+    static constexpr size_t SMALL_K = 8;
+private:
+    size_t m_k;
+    uint64_t m_small[SMALL_K] = {0}; // ascending, m_small[0] is the smallest kept value
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> m_heap;
+
+    void push_small(uint64_t value)
+    {
+        if(value <= m_small[0])
+        {
+            return;
+        }
+        // drop m_small[0] and insert value: every slot below the insertion point takes its upper
+        // neighbour, the insertion point takes value, and the slots above it keep their value
+        for(size_t i = 0; i < m_k; i++)
+        {
+            uint64_t next = (i + 1 < m_k) ? m_small[i + 1] : std::numeric_limits<uint64_t>::max();
+            uint64_t kept = (value > m_small[i]) ? value : m_small[i];
+            m_small[i] = (value > next) ? next : kept;
+        }
+    }
+
+    void push_heap(uint64_t value)
+    {
+        if(m_heap.size() < m_k)
+        {
+            m_heap.push(value);
+        }
+        else if(value > m_heap.top())
+        {
+            m_heap.pop();
+            m_heap.push(value);
+        }
+    }
+public:
+    explicit TopK(size_t k) : m_k(k) {}
+
+    size_t k() const { return m_k; }
+
+    void push(uint64_t value)
+    {
+        if(m_k == 0)
+            return;
+        if(m_k <= SMALL_K)
+            push_small(value);
+        else
+            push_heap(value);
+    }
+
+    // the kept values, biggest first
+    std::vector<uint64_t> values() const
+    {
+        std::vector<uint64_t> result;
+        if(m_k <= SMALL_K)
+        {
+            result.assign(m_small, m_small + m_k);
+        }
+        else
+        {
+            auto heap = m_heap;
+            while(!heap.empty())
+            {
+                result.push_back(heap.top());
+                heap.pop();
+            }
+            result.resize(m_k, 0);
+        }
+        std::sort(result.begin(), result.end(), std::greater<uint64_t>());
+        return result;
+    }
+
+    uint64_t sum() const
+    {
+        uint64_t total = 0;
+        for(uint64_t value : values())
+            total += value;
+        return total;
+    }
+};
+
+#endif
@@ -5,6 +5,11 @@
 #include <stdbool.h>
 #include <math.h>
 
+#include "../utils/parse_int.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
+
 /*
 part a:
 the cpu holds:
@@ -43,9 +48,29 @@ typedef struct
     int32_t x_register;
     uint32_t signal_strength_sum;
     uint32_t* target_cycles;
+    char* screen; // the rendered pixels, a '\n' starts every row
+    size_t screen_size;
+    size_t screen_capacity;
 } cpu_t;
 
-#define CPU_INITIALIZER {1, 0, NULL}
+#define CPU_INITIALIZER {1, 0, NULL, NULL, 0, 0}
+
+void screen_put(cpu_t* cpu, char pixel)
+{
+    if (cpu->screen_size + 1 >= cpu->screen_capacity)
+    {
+        size_t capacity = cpu->screen_capacity ? cpu->screen_capacity * 2 : (CRT_WIDTH + 1) * CRT_HRIGHT + 1;
+        char* screen = realloc(cpu->screen, capacity);
+        if (!screen)
+        {
+            return; // the pixel is lost, the signal strength is still correct
+        }
+        cpu->screen = screen;
+        cpu->screen_capacity = capacity;
+    }
+    cpu->screen[cpu->screen_size++] = pixel;
+    cpu->screen[cpu->screen_size] = '\0';
+}
 
 typedef enum
 {
@@ -77,7 +102,10 @@ instruction_t parse_line(const char* line)
     else if (strncmp(line, "addx", 4) == 0)
     {
         instruction.opcode = ADDX;
-        instruction.value = atoi(line + 5);
+        if (!parse_int32(line + 5, line + strlen(line), &instruction.value))
+        {
+            printf("invalid addx operand: %s\n", line);
+        }
     }
     else
     {
@@ -109,14 +137,13 @@ void exec_instruction(uint32_t* global_cycle_counter, cpu_t* cpu, instruction_t
         // part b
         // determine if the current pixel is ON
         // the x register marks the middle of the sprite (should always be between 1 and 40)
-        //! @todo extract the pixels to a 2d array and print it later
         char current_pixel_state = OFF_PIXEL;
         uint32_t current_pixel_x_pos = (((*global_cycle_counter) - 1) % CRT_WIDTH);// + 1;
         uint32_t current_pixel_y_pos = (((*global_cycle_counter) - 1) / CRT_WIDTH);// + 1;
 
         if (current_pixel_x_pos == 0) // start of new line
         {
-            printf("\n");
+            screen_put(cpu, '\n');
         }
 
         for(uint32_t i = 0; i < 3; i++)
@@ -129,8 +156,8 @@ void exec_instruction(uint32_t* global_cycle_counter, cpu_t* cpu, instruction_t
                 current_pixel_state = ON_PIXEL;
             }
         }
-        // print the pixel
-        printf("%c", current_pixel_state);
+        // render the pixel, the screen is printed once the program is done
+        screen_put(cpu, current_pixel_state);
         
 
         // tick the cycle counter
@@ -150,34 +177,107 @@ void exec_instruction(uint32_t* global_cycle_counter, cpu_t* cpu, instruction_t
     }
 }
 
-int main()
+/*
+run the whole program, both parts are computed by the same pass
+returns false if the file could not be opened
+*/
+bool run_program(const char* input, cpu_t* cpu)
 {
-    // open input file
     char line_buffer[64] = {0};
-    const char* input = "input.txt";
     FILE* file = fopen(input, "r");
     if (!file)
     {
         printf("failed to open file: %s\n", input);
-        return 1;
+        return false;
     }
 
     // init cpu
     uint32_t global_cycle_counter = 1;
-    cpu_t cpu = CPU_INITIALIZER;
-    cpu.target_cycles = calloc(TARGET_CYCLES_COUNT, sizeof(uint32_t));
+    cpu->target_cycles = calloc(TARGET_CYCLES_COUNT, sizeof(uint32_t));
     for (int i = 0; i < TARGET_CYCLES_COUNT; i++)
     {
-        cpu.target_cycles[i] = FIRST_TARGET_CYCLE + i * TARGET_CYCLE_STEP;
+        cpu->target_cycles[i] = FIRST_TARGET_CYCLE + i * TARGET_CYCLE_STEP;
     }
 
     // parse instructions
+    PERF_BEGIN(run, "read+parse+solve both parts");
     while (fgets(line_buffer, sizeof(line_buffer), file))
     {
         instruction_t instruction = parse_line(line_buffer);
-        exec_instruction(&global_cycle_counter, &cpu, instruction);
+        exec_instruction(&global_cycle_counter, cpu, instruction);
+    }
+    PERF_END(run);
+    fclose(file);
+    return true;
+}
+
+void release_cpu(cpu_t* cpu)
+{
+    free(cpu->target_cycles);
+    free(cpu->screen);
+}
+
+static void* solver_parse(const char* input_path)
+{
+    cpu_t* cpu = malloc(sizeof(cpu_t));
+    if (!cpu)
+    {
+        return NULL;
+    }
+    *cpu = (cpu_t)CPU_INITIALIZER;
+    if (!run_program(input_path, cpu))
+    {
+        release_cpu(cpu);
+        free(cpu);
+        return NULL;
+    }
+    return cpu;
+}
+
+static bool solver_part1(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, ((cpu_t*)state)->signal_strength_sum);
+}
+
+static bool solver_part2(void* state, char* answer, size_t answer_size)
+{
+    const cpu_t* cpu = (const cpu_t*)state;
+    // skip the '\n' in front of the first row
+    return cpu->screen && solver_answer_str(answer, answer_size, cpu->screen + 1);
+}
+
+static void solver_release(void* state)
+{
+    release_cpu((cpu_t*)state);
+    free(state);
+}
+
+const solver_t task_10_solver = {"task_10", solver_parse, solver_part1, solver_part2, solver_release};
+
+#ifndef AOC_RUNNER
+int main(int argc, char* argv[])
+{
+    // both parts are computed by the same pass over the program,
+    // the part argument is only validated to keep the command line the same for every day
+    if (parse_part_arg(argc, argv) == PART_INVALID)
+    {
+        return 1;
+    }
+
+    cpu_t cpu = CPU_INITIALIZER;
+    if (!run_program("input.txt", &cpu))
+    {
+        return 1;
     }
 
+    // part b:
+    if (cpu.screen)
+    {
+        fputs(cpu.screen, stdout);
+    }
     // part a:
     printf("\npart a: %u\n", cpu.signal_strength_sum);
-}
\ No newline at end of file
+    release_cpu(&cpu);
+    PERF_REPORT();
+}
+#endif
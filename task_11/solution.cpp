@@ -5,10 +5,12 @@
 #include <vector>
 #include <string>
 #include <cassert>
+#include <memory_resource>
 
 #include "expected.hpp"
 #include "optional.hpp"
 #include "format.hpp"
+#include "../utils/arena.h"
 
 typedef int32_t (*operation_fp)(int32_t);
 typedef bool (*test_fp)(int32_t);
@@ -18,9 +20,14 @@ class Monkey; // forward declaration
 class Game
 {
     private:
-    std::vector<Monkey> monkeys;
+    // the items of every monkey live in the arena, the pool recycles the deque blocks
+    // that are freed when items move between monkeys so the arena does not keep growing
+    ArenaResource arena;
+    std::pmr::unsynchronized_pool_resource items_pool;
+    std::deque<Monkey> monkeys; // deque - pointers handed out by get_monkey() stay valid
     public:
-    Game() {}
+    Game() : items_pool(&arena) {}
+    ~Game();
     bool add_monkey(uint32_t monkey_id, uint32_t next_success_id, uint32_t next_fail_id, operation_fp inspect_fp, test_fp test);
     Expected<Monkey*, std::string> get_monkey(uint32_t monkey_id);
     void play(uint32_t rounds);
@@ -33,11 +40,11 @@ class Monkey
     uint32_t next_success_monkey_id;
     uint32_t next_fail_monkey_id;
     int32_t inspection_counter;
-    std::deque<int32_t> items;
+    std::pmr::deque<int32_t> items;
     operation_fp inspect_fp;
     public:
-    Monkey(uint32_t monkey_id, uint32_t next_success_monkey_id, uint32_t next_fail_monkey_id, operation_fp inspect_fp, test_fp test) : 
-        monkey_id(monkey_id), next_success_monkey_id(next_success_monkey_id), next_fail_monkey_id(next_fail_monkey_id), inspect_fp(inspect_fp), test_item(test) {}
+    Monkey(uint32_t monkey_id, uint32_t next_success_monkey_id, uint32_t next_fail_monkey_id, operation_fp inspect_fp, test_fp test, std::pmr::memory_resource* resource) : 
+        monkey_id(monkey_id), next_success_monkey_id(next_success_monkey_id), next_fail_monkey_id(next_fail_monkey_id), inspection_counter(0), items(resource), inspect_fp(inspect_fp), test_item(test) {}
     bool add_item(int32_t item);
     Expected<int32_t, std::string> peak_item(void);
     Expected<int32_t, std::string> pop_item(void);
@@ -112,7 +119,7 @@ bool Game::add_monkey(uint32_t monkey_id, uint32_t next_success_id, uint32_t nex
 {
     try
     {
-        monkeys.push_back(Monkey(monkey_id, next_success_id, next_fail_id, inspect_fp, test));
+        monkeys.emplace_back(monkey_id, next_success_id, next_fail_id, inspect_fp, test, &items_pool);
     }
     catch(const std::bad_alloc& e)
     {
@@ -136,13 +143,21 @@ void Game::play(uint32_t rounds)
 {
     for(uint32_t round = 0; round < rounds; round++)
     {
-        for(Monkey monkey : monkeys)
+        for(Monkey& monkey : monkeys)
         {
             monkey.play_round(*this);
         }
     }
 }
 
+Game::~Game()
+{
+    monkeys.clear(); // give the items back to the pool before it goes away
+#ifdef ARENA_STATS
+    arena.print_stats("task_11 items");
+#endif
+}
+
 /*
 test functions
 */
@@ -0,0 +1,161 @@
+#ifndef GAME_RULES_H
+#define GAME_RULES_H
+
+#include <array>
+#include <cstdint>
+
+/*
+rock paper scissors with any odd number of shapes N, every table generated at compile time
+
+shape i beats shape j when (i - j) mod N is odd, which gives every shape (N - 1) / 2 wins and
+as many losses. N = 3 is rock, paper, scissors, N = 5 is rock, paper, scissors, spock, lizard.
+a round scores the bonus of the player's shape (its index + 1) plus the outcome.
+
+the input is "<opponent> <second column>":
+- the opponent plays 'A' + shape
+- part one reads the second column as the player's shape, 'Z' - (N - 1) + shape
+- part two reads it as the outcome the player needs, 'X' lose, 'Y' draw, 'Z' win.
+  for N > 3 several shapes give the same outcome, the neighbours of the opponent's shape are
+  played (opponent + 1 wins, opponent - 1 loses), for N = 3 they are the only choice.
+*/
+
+typedef enum
+{
+    LOSS = 0,
+    DRAW = 3,
+    WIN = 6
+} result_score_e;
+
+typedef enum
+{
+    OUTCOME_LOSE = 0,
+    OUTCOME_DRAW,
+    OUTCOME_WIN,
+    OUTCOMES_SIZE
+} outcome_e;
+
+template <uint32_t N>
+class GameRules
+{
+    static_assert(N >= 3 && N % 2 == 1, "every shape needs as many wins as losses, N must be odd");
+    static_assert(N <= 26, "the player letters run out");
+public:
+    static constexpr uint32_t SHAPES = N;
+    static constexpr uint32_t PATTERNS = N * N; // every "<opponent> <second column>" line
+    static constexpr char FIRST_OPPONENT = 'A';
+    static constexpr char FIRST_PLAYER = 'Z' - (N - 1);
+    static constexpr char FIRST_OUTCOME = 'X';
+    static constexpr uint32_t INVALID_SCORE = UINT32_MAX; // a line one of the parts can not read
+
+    typedef std::array<uint32_t, PATTERNS> score_table_t;
+
+    static constexpr result_score_e result(uint32_t player, uint32_t opponent)
+    {
+        uint32_t difference = (player + N - opponent) % N;
+        if(difference == 0)
+            return DRAW;
+        return (difference % 2 == 1) ? WIN : LOSS;
+    }
+
+    static constexpr uint32_t bonus(uint32_t player)
+    {
+        return player + 1;
+    }
+
+    static constexpr uint32_t move_for_outcome(uint32_t opponent, outcome_e outcome)
+    {
+        switch(outcome)
+        {
+            case OUTCOME_LOSE:
+                return (opponent + N - 1) % N;
+            case OUTCOME_WIN:
+                return (opponent + 1) % N;
+            default:
+                return opponent;
+        }
+    }
+
+    static constexpr uint32_t round_score(uint32_t player, uint32_t opponent)
+    {
+        return bonus(player) + result(player, opponent);
+    }
+
+    // index of the line "<opponent> <second column>" in the score tables, -1 if it is not a line of this game
+    static constexpr int32_t pattern_index(char first, char second)
+    {
+        uint32_t opponent = static_cast<uint8_t>(first - FIRST_OPPONENT);
+        uint32_t column = static_cast<uint8_t>(second - FIRST_PLAYER);
+        if(opponent >= N || column >= N)
+            return -1;
+        return static_cast<int32_t>(opponent * N + column);
+    }
+
+private:
+    static constexpr std::array<std::array<uint32_t, N>, N> make_result_map()
+    {
+        std::array<std::array<uint32_t, N>, N> map = {};
+        for(uint32_t player = 0; player < N; player++)
+            for(uint32_t opponent = 0; opponent < N; opponent++)
+                map[player][opponent] = result(player, opponent);
+        return map;
+    }
+
+    static constexpr std::array<uint32_t, N> make_bonus_map()
+    {
+        std::array<uint32_t, N> map = {};
+        for(uint32_t player = 0; player < N; player++)
+            map[player] = bonus(player);
+        return map;
+    }
+
+    static constexpr std::array<std::array<uint32_t, OUTCOMES_SIZE>, N> make_move_map()
+    {
+        std::array<std::array<uint32_t, OUTCOMES_SIZE>, N> map = {};
+        for(uint32_t opponent = 0; opponent < N; opponent++)
+            for(uint32_t outcome = 0; outcome < OUTCOMES_SIZE; outcome++)
+                map[opponent][outcome] = move_for_outcome(opponent, static_cast<outcome_e>(outcome));
+        return map;
+    }
+
+    static constexpr score_table_t make_part_one_scores()
+    {
+        score_table_t scores = {};
+        for(uint32_t opponent = 0; opponent < N; opponent++)
+            for(uint32_t player = 0; player < N; player++)
+                scores[opponent * N + player] = round_score(player, opponent);
+        return scores;
+    }
+
+    static constexpr score_table_t make_part_two_scores()
+    {
+        score_table_t scores = {};
+        for(uint32_t opponent = 0; opponent < N; opponent++)
+        {
+            for(uint32_t column = 0; column < N; column++)
+            {
+                uint32_t outcome = column + FIRST_PLAYER - FIRST_OUTCOME; // wraps for the letters before 'X'
+                scores[opponent * N + column] = (outcome < OUTCOMES_SIZE)
+                    ? round_score(move_for_outcome(opponent, static_cast<outcome_e>(outcome)), opponent)
+                    : INVALID_SCORE;
+            }
+        }
+        return scores;
+    }
+
+public:
+    // RESULT_MAP[player][opponent], BONUS_MAP[player], MOVE_MAP[opponent][outcome]
+    static constexpr std::array<std::array<uint32_t, N>, N> RESULT_MAP = make_result_map();
+    static constexpr std::array<uint32_t, N> BONUS_MAP = make_bonus_map();
+    static constexpr std::array<std::array<uint32_t, OUTCOMES_SIZE>, N> MOVE_MAP = make_move_map();
+    // the score of every line (pattern_index) for both readings of the second column
+    static constexpr score_table_t PART_ONE_SCORES = make_part_one_scores();
+    static constexpr score_table_t PART_TWO_SCORES = make_part_two_scores();
+};
+
+// the hand written tables of the original puzzle
+static_assert(GameRules<3>::RESULT_MAP[0][2] == WIN && GameRules<3>::RESULT_MAP[0][1] == LOSS, "rock beats scissors, loses to paper");
+static_assert(GameRules<3>::MOVE_MAP[0][OUTCOME_LOSE] == 2 && GameRules<3>::MOVE_MAP[0][OUTCOME_WIN] == 1, "lose to rock with scissors, win with paper");
+static_assert(GameRules<3>::PART_ONE_SCORES[GameRules<3>::pattern_index('A', 'Y')] == 8, "A Y scores 8 in part one");
+static_assert(GameRules<3>::PART_TWO_SCORES[GameRules<3>::pattern_index('A', 'Y')] == 4, "A Y scores 4 in part two");
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef ROUND_HISTOGRAM_H
+#define ROUND_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "../utils/scanner.h"
+#include "game_rules.h"
+
+/*
+a round is one of only N * N lines "<opponent> <second column>" (9 for the original game),
+so the whole input reduces to how many times each of them appears. the counts are taken in
+a single pass over the raw bytes, and a score is then the dot product of the counts with
+a table of the round scores (GameRules<N>::PART_ONE_SCORES / PART_TWO_SCORES).
+
+the pattern index is (opponent letter - 'A') * N + (second column - GameRules<N>::FIRST_PLAYER).
+*/
+
+template <uint32_t N>
+struct round_histogram_s
+{
+    uint64_t counts[GameRules<N>::PATTERNS];
+};
+
+// index of the round "first ? second", throws std::invalid_argument if it is not a round
+template <uint32_t N>
+inline uint32_t round_pattern_index(char first, char second)
+{
+    int32_t index = GameRules<N>::pattern_index(first, second);
+    if(index < 0)
+    {
+        throw std::invalid_argument("round_pattern_index(): invalid round: " + std::string(1, first) + " " + std::string(1, second));
+    }
+    return static_cast<uint32_t>(index);
+}
+
+/*
+the lines of the input are all "X Y\n" except maybe the last one, so the main loop takes
+4 bytes at a time. the counts are spread over 4 tables (one per line modulo 4) so that two
+neighbouring lines of the same round do not wait on each other's increment.
+anything else (a last line without newline, '\r', blank lines) goes through the slow path.
+*/
+template <uint32_t N>
+inline round_histogram_s<N> build_round_histogram(std::string_view data)
+{
+    const uint32_t patterns = GameRules<N>::PATTERNS;
+    uint64_t lanes[4][patterns] = {{0}};
+    const char* pos = data.data();
+    const char* end = pos + data.size();
+    size_t line = 0;
+    while(pos < end)
+    {
+        if(end - pos >= 4 && pos[1] == ' ' && pos[3] == '\n')
+        {
+            lanes[line & 3][round_pattern_index<N>(pos[0], pos[2])]++;
+            pos += 4;
+            line++;
+            continue;
+        }
+        size_t length = scan_find_char(pos, end - pos, '\n');
+        size_t content_length = (length > 0 && pos[length - 1] == '\r') ? length - 1 : length;
+        if(content_length == 3 && pos[1] == ' ')
+        {
+            lanes[line & 3][round_pattern_index<N>(pos[0], pos[2])]++;
+            line++;
+        }
+        else if(content_length != 0)
+        {
+            throw std::invalid_argument("build_round_histogram(): invalid line: " + std::string(pos, length));
+        }
+        pos += length + 1;
+    }
+
+    round_histogram_s<N> histogram;
+    for(uint32_t i = 0; i < patterns; i++)
+        histogram.counts[i] = lanes[0][i] + lanes[1][i] + lanes[2][i] + lanes[3][i];
+    return histogram;
+}
+
+/*
+throws std::invalid_argument if a line the table can not score (GameRules<N>::INVALID_SCORE) was counted
+*/
+template <uint32_t N>
+inline uint64_t round_histogram_dot(const round_histogram_s<N>& histogram, const typename GameRules<N>::score_table_t& scores)
+{
+    uint64_t total = 0;
+    for(uint32_t i = 0; i < GameRules<N>::PATTERNS; i++)
+    {
+        if(scores[i] == GameRules<N>::INVALID_SCORE)
+        {
+            if(histogram.counts[i] != 0)
+                throw std::invalid_argument("round_histogram_dot(): the input has rounds this part can not score");
+            continue;
+        }
+        total += histogram.counts[i] * scores[i];
+    }
+    return total;
+}
+
+#endif
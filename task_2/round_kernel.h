@@ -0,0 +1,141 @@
+#ifndef ROUND_KERNEL_H
+#define ROUND_KERNEL_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "../utils/scanner.h"
+#include "round_histogram.h"
+
+/*
+vectorized scoring of the rounds straight from the raw (mapped) buffer
+
+a block of 32 bytes is 8 "A Y\n" records, one per 32-bit lane. the two letters are turned
+into the pattern index (opponent * 3 + column) inside the lane, and a byte shuffle (pshufb)
+with the 9 scores of a part held in a register looks up the score of all 8 rounds at once.
+both parts are looked up from the same index and packed in the two 16-bit halves of the lane,
+the lanes are summed with 16-bit adds and widened before they can overflow.
+a block that is not 8 well formed records (blank line, '\r', the end of the buffer) goes
+through the histogram one line at a time, which also reports invalid rounds.
+
+the kernel is written for the original 3 shape game (GameRules<3>), whose 9 scores fit in a
+single 16 byte shuffle table. pshufb needs SSSE3, so the kernel is only built for AVX2 (picked
+with the scanner's cpuid dispatch), the other machines score through the histogram.
+*/
+
+typedef GameRules<3> KernelRules;
+
+typedef struct
+{
+    uint64_t rounds;
+    uint64_t part_one;
+    uint64_t part_two;
+} round_scores_s;
+
+static inline void round_scores_add_histogram(round_scores_s& scores, const round_histogram_s<3>& histogram)
+{
+    for(uint32_t i = 0; i < KernelRules::PATTERNS; i++)
+        scores.rounds += histogram.counts[i];
+    scores.part_one += round_histogram_dot<3>(histogram, KernelRules::PART_ONE_SCORES);
+    scores.part_two += round_histogram_dot<3>(histogram, KernelRules::PART_TWO_SCORES);
+}
+
+static inline round_scores_s score_rounds_scalar(std::string_view data)
+{
+    round_scores_s scores = {0, 0, 0};
+    round_scores_add_histogram(scores, build_round_histogram<3>(data));
+    return scores;
+}
+
+#ifdef SCANNER_X86
+
+SCANNER_TARGET("avx2")
+static inline __m256i round_score_table_avx2(const KernelRules::score_table_t& scores)
+{
+    alignas(32) uint8_t bytes[32] = {0};
+    for(uint32_t i = 0; i < KernelRules::PATTERNS; i++)
+        bytes[i] = bytes[16 + i] = static_cast<uint8_t>(scores[i]); // vpshufb looks up inside each 128-bit half
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(bytes));
+}
+
+SCANNER_TARGET("avx2")
+static inline void round_flush_avx2(round_scores_s& scores, __m256i& accumulator)
+{
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), accumulator);
+    for(uint32_t lane : lanes)
+    {
+        scores.part_one += lane & 0xFFFF;
+        scores.part_two += lane >> 16;
+    }
+    accumulator = _mm256_setzero_si256();
+}
+
+SCANNER_TARGET("avx2")
+static inline round_scores_s score_rounds_avx2(std::string_view data)
+{
+    const uint32_t max_blocks = 65535 / 9; // a 16-bit half gains at most 9 per block, flush before it wraps
+    const __m256i layout_mask = _mm256_set1_epi32(static_cast<int>(0xFF00FF00));
+    const __m256i layout = _mm256_set1_epi32(('\n' << 24) | (' ' << 8));
+    const __m256i letter_base = _mm256_set1_epi32((KernelRules::FIRST_PLAYER << 16) | KernelRules::FIRST_OPPONENT);
+    const __m256i letter_mask = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i max_letter = _mm256_set1_epi8(2);
+    const __m256i index_mask = _mm256_set1_epi32(static_cast<int>(0xFFFFFF00)); // the other bytes look up 0
+    const __m256i part_one_table = round_score_table_avx2(KernelRules::PART_ONE_SCORES);
+    const __m256i part_two_table = round_score_table_avx2(KernelRules::PART_TWO_SCORES);
+
+    round_scores_s scores = {0, 0, 0};
+    round_histogram_s<3> leftovers = {{0}};
+    __m256i accumulator = _mm256_setzero_si256();
+    uint32_t num_blocks = 0;
+    const char* pos = data.data();
+    const char* end = pos + data.size();
+    while(end - pos >= 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        __m256i letters = _mm256_and_si256(_mm256_sub_epi8(block, letter_base), letter_mask);
+        __m256i is_layout = _mm256_cmpeq_epi32(_mm256_and_si256(block, layout_mask), layout);
+        __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letters, max_letter), letters);
+        if(_mm256_movemask_epi8(_mm256_and_si256(is_layout, is_letter)) != -1)
+        {
+            size_t length = scan_find_char(pos, end - pos, '\n');
+            size_t line_size = (pos + length < end) ? length + 1 : length;
+            round_histogram_s<3> line = build_round_histogram<3>(std::string_view(pos, line_size));
+            for(uint32_t i = 0; i < KernelRules::PATTERNS; i++)
+                leftovers.counts[i] += line.counts[i];
+            pos += line_size;
+            continue;
+        }
+        __m256i opponent = _mm256_and_si256(letters, _mm256_set1_epi32(0xFF));
+        __m256i column = _mm256_srli_epi32(letters, 16);
+        __m256i index = _mm256_add_epi32(_mm256_add_epi32(opponent, _mm256_slli_epi32(opponent, 1)), column);
+        index = _mm256_or_si256(index, index_mask);
+        __m256i part_one = _mm256_shuffle_epi8(part_one_table, index);
+        __m256i part_two = _mm256_shuffle_epi8(part_two_table, index);
+        accumulator = _mm256_add_epi16(accumulator, _mm256_or_si256(part_one, _mm256_slli_epi32(part_two, 16)));
+        scores.rounds += 8;
+        pos += 32;
+        if(++num_blocks == max_blocks)
+        {
+            round_flush_avx2(scores, accumulator);
+            num_blocks = 0;
+        }
+    }
+    round_flush_avx2(scores, accumulator);
+    round_scores_add_histogram(scores, leftovers);
+    round_scores_add_histogram(scores, build_round_histogram<3>(std::string_view(pos, end - pos)));
+    return scores;
+}
+
+#endif // SCANNER_X86
+
+static inline round_scores_s score_rounds(std::string_view data)
+{
+#ifdef SCANNER_X86
+    if(scan_detect_isa() == SCAN_ISA_AVX2)
+        return score_rounds_avx2(data);
+#endif
+    return score_rounds_scalar(data);
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef ROUND_STREAM_H
+#define ROUND_STREAM_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "game_rules.h"
+#include "round_histogram.h"
+
+/*
+pattern index of one line without its newline, returns false for a blank line
+throws std::invalid_argument if it is not a round
+*/
+template <uint32_t N>
+inline bool round_line_pattern(std::string_view line, uint32_t& pattern)
+{
+    if(!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    if(line.empty())
+        return false;
+    if(line.length() != 3 || line[1] != ' ')
+        throw std::invalid_argument("round_line_pattern(): invalid line: " + std::string(line));
+    pattern = round_pattern_index<N>(line[0], line[2]);
+    return true;
+}
+
+/*
+streaming scorer: every line is read once and updates the totals of both parts,
+nothing is stored, so the memory does not depend on the number of rounds.
+lines come from anywhere (StreamReader, a pipe, a socket), in any number of calls.
+
+the second column of part two only has 3 letters, with more than 3 shapes a line can be
+valid for part one and not for part two, such lines are counted and part_two() refuses to answer.
+*/
+template <uint32_t N>
+class RoundScorer
+{
+private:
+    typedef GameRules<N> Rules;
+    uint64_t m_rounds = 0;
+    uint64_t m_part_one = 0;
+    uint64_t m_part_two = 0;
+    uint64_t m_part_two_invalid = 0;
+public:
+    void add_pattern(uint32_t pattern)
+    {
+        uint32_t part_two = Rules::PART_TWO_SCORES[pattern];
+        bool is_invalid = (part_two == Rules::INVALID_SCORE);
+        m_rounds++;
+        m_part_one += Rules::PART_ONE_SCORES[pattern];
+        m_part_two += is_invalid ? 0 : part_two;
+        m_part_two_invalid += is_invalid;
+    }
+
+    // one line without its newline, blank lines are skipped
+    void add_line(std::string_view line)
+    {
+        uint32_t pattern;
+        if(round_line_pattern<N>(line, pattern))
+            add_pattern(pattern);
+    }
+
+    uint64_t rounds() const { return m_rounds; }
+    uint64_t part_one() const { return m_part_one; }
+
+    uint64_t part_two() const
+    {
+        if(m_part_two_invalid)
+            throw std::invalid_argument("RoundScorer::part_two(): the input has rounds this part can not score");
+        return m_part_two;
+    }
+};
+
+/*
+rounds that have to be kept (replays, per round reports) are stored as their pattern index,
+4 bits per round instead of two 4-byte enums, 1B rounds take 500 MB instead of 8 GB.
+only the games of up to 16 patterns fit (the 3 shape puzzle has 9).
+*/
+template <uint32_t N>
+class PackedRounds
+{
+    static_assert(GameRules<N>::PATTERNS <= 16, "a pattern index must fit in 4 bits");
+private:
+    std::vector<uint8_t> m_nibbles; // round 2i in the low nibble of byte i, round 2i + 1 in the high one
+    size_t m_size = 0;
+public:
+    size_t size() const { return m_size; }
+    size_t memory_bytes() const { return m_nibbles.capacity(); }
+    void reserve(size_t num_rounds) { m_nibbles.reserve((num_rounds + 1) / 2); }
+
+    void push_back(uint32_t pattern)
+    {
+        if(m_size % 2 == 0)
+            m_nibbles.push_back(static_cast<uint8_t>(pattern));
+        else
+            m_nibbles.back() |= static_cast<uint8_t>(pattern << 4);
+        m_size++;
+    }
+
+    uint32_t operator[](size_t index) const
+    {
+        return (m_nibbles[index / 2] >> (4 * (index % 2))) & 0xF;
+    }
+
+    // both parts of the kept rounds
+    RoundScorer<N> score() const
+    {
+        RoundScorer<N> scorer;
+        for(size_t i = 0; i < m_size; i++)
+            scorer.add_pattern((*this)[i]);
+        return scorer;
+    }
+};
+
+#endif
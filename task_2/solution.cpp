@@ -1,161 +1,299 @@
 
-#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <future>
 #include <iostream>
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <vector>
 
-using namespace std;
+#include <sys/stat.h>
 
-const char OPPONENT_ROCK     = 'A';
-const char OPPONENT_PAPER    = 'B';
-const char OPPONENT_SCISSORS = 'C';
+#include "../utils/line_ranges.h"
+#include "../utils/mapped_file.h"
+#include "../utils/parse_int.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
+#include "../utils/stream_reader.h"
+#include "../utils/thread_pool.h"
+#include "game_rules.h"
+#include "round_histogram.h"
+#include "round_kernel.h"
+#include "round_stream.h"
 
-const char PLAYER_ROCK      = 'X';
-const char PLAYER_PAPER     = 'Y';
-const char PLAYER_SCISSORS  = 'Z';
+using namespace std;
 
-const char SHOULD_LOSE = 'X';
-const char SHOULD_DRAW = 'Y';
-const char SHOULD_WIN  = 'Z';
+/*
+the rules and their score tables are generated at compile time for any odd number of shapes
+(game_rules.h), the puzzle is the 3 shape game
+*/
+typedef GameRules<3> PuzzleRules;
 
-typedef enum
+template <uint32_t N>
+round_histogram_s<N> load_data(string path)
 {
-    ROCK = 0,
-    PAPER,
-    SCISSORS,
-    SHAPE_LAST_INDEX = SCISSORS
-} shape_e;
+    PERF_BEGIN(read, "read");
+    MappedFile data_file(path);
+    data_file.prefault();
+    PERF_END(read);
+    PERF_SCOPE("parse");
+    return build_round_histogram<N>(data_file.data());
+}
 
-#define SHAPES_SIZE (SHAPE_LAST_INDEX + 1)
+template <uint32_t N>
+uint64_t get_total_score(const round_histogram_s<N>& histogram, bool is_part_two)
+{
+    PERF_SCOPE(is_part_two ? "part 2: solve" : "part 1: solve");
+    return round_histogram_dot<N>(histogram, is_part_two ? GameRules<N>::PART_TWO_SCORES : GameRules<N>::PART_ONE_SCORES);
+}
 
-typedef enum
+/*
+both parts scored at once by the vectorized kernel (round_kernel.h), no histogram is kept
+*/
+round_scores_s score_file_simd(string path)
 {
-    ROCK_BONUS = 1,
-    PAPER_BONUS,
-    SCISSORS_BONUS
-} shape_bonus_e;
+    PERF_BEGIN(read, "read");
+    MappedFile data_file(path);
+    data_file.prefault();
+    PERF_END(read);
+    PERF_SCOPE("parse+solve both parts");
+    return score_rounds(data_file.data());
+}
 
-typedef enum
+/*
+parallel mode: the mapped file is cut into one range of whole lines per worker, every worker
+reduces its range on its own (a histogram, or both scores with the kernel) and the partials
+are summed in the calling thread (the ranges come from utils/line_ranges.h)
+*/
+template <typename Partial, typename ReduceRange>
+vector<Partial> reduce_ranges(string path, size_t num_threads, ReduceRange reduce_range)
 {
-    LOSS = 0,
-    DRAW = 3,
-    WIN = 6
-} result_score_e;
+    PERF_BEGIN(read, "read");
+    MappedFile data_file(path);
+    data_file.prefault();
+    PERF_END(read);
+    PERF_SCOPE("parse+reduce (parallel)");
+    string_view data = data_file.data();
+    ThreadPool pool(num_threads);
+    size_t num_ranges = count_line_ranges(data.size(), pool);
+    vector<future<Partial>> futures;
+    for(string_view range : split_on_lines(data, num_ranges))
+        futures.push_back(pool.submit([range, reduce_range] { return reduce_range(range); }));
+    vector<Partial> partials;
+    for(future<Partial>& partial : futures)
+        partials.push_back(partial.get());
+    return partials;
+}
 
-const uint32_t result_map[SHAPES_SIZE][SHAPES_SIZE] =
+template <uint32_t N>
+round_histogram_s<N> load_data_parallel(string path, size_t num_threads)
 {
+    round_histogram_s<N> histogram = {{0}};
+    auto partials = reduce_ranges<round_histogram_s<N>>(path, num_threads, build_round_histogram<N>);
+    for(const round_histogram_s<N>& partial : partials)
     {
-        {DRAW}, //OPPONENT ROCK
-        {LOSS}, //OPPONENT PAPER
-        {WIN}, //OPPONENT SCISSORS
-    }, //PLAYER ROCK
-    {
-        {WIN}, //OPPONENT ROCK
-        {DRAW}, //OPPONENT PAPER
-        {LOSS}, //OPPONENT SCISSORS
-    }, //PLAYER PAPER
+        for(uint32_t i = 0; i < GameRules<N>::PATTERNS; i++)
+            histogram.counts[i] += partial.counts[i];
+    }
+    return histogram;
+}
+
+round_scores_s score_file_simd_parallel(string path, size_t num_threads)
+{
+    round_scores_s scores = {0, 0, 0};
+    for(const round_scores_s& partial : reduce_ranges<round_scores_s>(path, num_threads, score_rounds))
     {
-        {LOSS}, //OPPONENT ROCK
-        {WIN}, //OPPONENT PAPER
-        {DRAW}, //OPPONENT SCISSORS
-    }, //PLAYER SCISSORS
-};
+        scores.rounds += partial.rounds;
+        scores.part_one += partial.part_one;
+        scores.part_two += partial.part_two;
+    }
+    return scores;
+}
 
-const uint32_t bonus_map[SHAPES_SIZE] = 
+/*
+streaming mode: a single read of the file through the bounded StreamReader ring updates both
+parts (round_stream.h), for inputs that are too big to map or come from a pipe
+*/
+template <uint32_t N>
+RoundScorer<N> score_file_stream(string path)
 {
-    ROCK_BONUS, PAPER_BONUS, SCISSORS_BONUS
-};
+    PERF_SCOPE("read+parse+solve both parts");
+    StreamReader fp(path);
+    RoundScorer<N> scorer;
+    string_view line;
+    while(fp.next_line(line))
+        scorer.add_line(line);
+    return scorer;
+}
 
-int32_t calculate_round_score(shape_e player_move, shape_e opponent_move)
+/*
+the rounds kept in memory, 4 bits each
+the shortest round line is 4 bytes ("A X\n"), so a file of S bytes holds at most (S + 1) / 4 rounds
+(the last line may have no newline), reserving them up front keeps the vector from doubling past it
+*/
+PackedRounds<3> load_packed_rounds(string path)
 {
-    uint32_t score = 0;
-    score += bonus_map[player_move];
-    score += result_map[player_move][opponent_move];
-    //cout << "player move " << player_move << " opponent move " << opponent_move << " score " << score << endl;
-    return score;
+    PERF_SCOPE("read+parse (packed)");
+    StreamReader fp(path);
+    PackedRounds<3> rounds;
+    struct stat file_stat;
+    if(stat(path.c_str(), &file_stat) == 0 && S_ISREG(file_stat.st_mode))
+        rounds.reserve((static_cast<size_t>(file_stat.st_size) + 1) / 4);
+    string_view line;
+    uint32_t pattern;
+    while(fp.next_line(line))
+    {
+        if(round_line_pattern<3>(line, pattern))
+            rounds.push_back(pattern);
+    }
+    return rounds;
 }
 
 typedef struct
 {
-    shape_e player_move;
-    shape_e opponent_move;
-} round_shapes_s;
+    size_t num_threads = 1; // 1 is the plain single pass, 0 one worker per hardware thread
+    bool use_simd = false;  // the vectorized kernel, 3 shapes only
+    bool use_stream = false;
+    bool keep_rounds = false; // 3 shapes only
+} run_options_s;
 
-round_shapes_s get_round_shapes_from_line(string line, bool is_part_two = false)
+/*
+the 64-bit scores of the parts selected by part
+*/
+template <uint32_t N>
+void score_file(string path, int part, const run_options_s& options, uint64_t (&scores)[2])
 {
-    round_shapes_s result;
-    char opponent_move = line[0], second_col = line[2];
-
-    if(opponent_move == OPPONENT_ROCK)
-        result.opponent_move = ROCK;
-    else if(opponent_move == OPPONENT_PAPER)
-        result.opponent_move = PAPER;
-    else if(opponent_move == OPPONENT_SCISSORS)
-        result.opponent_move = SCISSORS;
-
-    if(!is_part_two)
+    if(options.use_stream)
     {
-        if(second_col == PLAYER_ROCK)
-            result.player_move = ROCK;
-        else if(second_col == PLAYER_PAPER)
-            result.player_move = PAPER;
-        else if(second_col == PLAYER_SCISSORS)
-            result.player_move = SCISSORS;
+        RoundScorer<N> scorer = score_file_stream<N>(path);
+        scores[0] = scorer.part_one();
+        if(should_run_part(part, 2))
+            scores[1] = scorer.part_two();
+        return;
     }
-    else
+    if constexpr(N == PuzzleRules::SHAPES)
     {
-        /* X = SHOULD WIN, Y = SHOULD DRAW, Z SHOULD LOSE */
-        result_score_e round_result;
-        if(second_col == SHOULD_LOSE)
-            round_result = LOSS;
-        else if(second_col == SHOULD_DRAW)
-            round_result = DRAW;
-        else // should win
-            round_result = WIN;
-
-        bool found = false;
-        for(uint32_t i = 0; i < SHAPES_SIZE; i++)
+        if(options.keep_rounds)
         {
-            if(result_map[i][result.opponent_move] == round_result)
-            {
-                result.player_move = static_cast<shape_e>(i);
-                found = true;
-                break;
-            }
+            PackedRounds<N> rounds = load_packed_rounds(path);
+            PERF_SCOPE("solve both parts (packed)");
+            RoundScorer<N> scorer = rounds.score();
+            scores[0] = scorer.part_one();
+            scores[1] = scorer.part_two();
+            cerr << rounds.size() << " rounds kept in " << rounds.memory_bytes() << " bytes" << endl;
+            return;
+        }
+        if(options.use_simd)
+        {
+            round_scores_s round_scores = (options.num_threads == 1) ? score_file_simd(path)
+                                                                     : score_file_simd_parallel(path, options.num_threads);
+            scores[0] = round_scores.part_one;
+            scores[1] = round_scores.part_two;
+            return;
         }
-        if(!found)
-            throw found;
     }
+    round_histogram_s<N> histogram = (options.num_threads == 1) ? load_data<N>(path)
+                                                                : load_data_parallel<N>(path, options.num_threads);
+    for(int current_part = 1; current_part <= 2; current_part++)
+    {
+        if(should_run_part(part, current_part))
+            scores[current_part - 1] = get_total_score<N>(histogram, current_part == 2);
+    }
+}
 
-    return result;
+// both parts are a dot product of the same histogram
+static void* solver_parse(const char* input_path)
+{
+    return new round_histogram_s<3>(load_data<3>(input_path));
 }
 
-vector<round_shapes_s> load_data(string path, bool is_part_two = false)
+static bool solver_part1(void* state, char* answer, size_t answer_size)
 {
-    vector<round_shapes_s> result;
-    fstream data_file;
-    string line;
-    data_file.open(path, ios::in);
-    round_shapes_s temp = {ROCK, ROCK};
-    while(getline(data_file, line))
-    {
-        //cout << "line: " << line << endl;
-        temp = get_round_shapes_from_line(line, is_part_two);
-        result.push_back(temp);
-        //cout << "player move " << temp.player_move << " opponent move " << temp.opponent_move << endl;
-    }
-    return result;
+    return solver_answer_u64(answer, answer_size, get_total_score<3>(*static_cast<round_histogram_s<3>*>(state), false));
+}
+
+static bool solver_part2(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, get_total_score<3>(*static_cast<round_histogram_s<3>*>(state), true));
+}
+
+static void solver_release(void* state)
+{
+    delete static_cast<round_histogram_s<3>*>(state);
 }
 
-int main()
+extern "C" const solver_t task_2_solver = {"task_2", solver_parse, solver_part1, solver_part2, solver_release};
+
+#ifndef AOC_RUNNER
+int usage(const char* name)
 {
-    uint32_t score = 0;
-    bool is_part_two = true;
-    vector<round_shapes_s> rounds = load_data("input.txt", is_part_two);
-    uint32_t length = rounds.size();
-    for(uint32_t i = 0; i < length; i++)
+    cerr << "usage: " << name << " [1|2] [--simd | --stream | --packed] [--shapes 3|5|7] [--threads N]" << endl;
+    return 1;
+}
+
+/*
+solution [1|2] [--simd | --stream | --packed] [--shapes 3|5|7] [--threads N]
+--simd      scores the mapped file with the vectorized kernel instead of building the histogram (3 shapes only)
+--stream    scores both parts in one read of the file without mapping it, in bounded memory
+--packed    keeps every round (4 bits each) before scoring them (3 shapes only)
+--shapes N  scores a tournament of the N shape variant (game_rules.h), the default is the 3 shape puzzle
+--threads N reduces the file with N workers (0 = one per hardware thread), the default is a single pass
+*/
+int main(int argc, char* argv[])
+{
+    bool has_part_arg = (argc > 1 && strncmp(argv[1], "--", 2) != 0);
+    int part = has_part_arg ? parse_part_arg(argc, argv) : PART_BOTH;
+    if(part == PART_INVALID)
+        return 1;
+    run_options_s options;
+    uint32_t num_shapes = PuzzleRules::SHAPES;
+    for(int i = has_part_arg ? 2 : 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--simd") == 0)
+            options.use_simd = true;
+        else if(strcmp(argv[i], "--stream") == 0)
+            options.use_stream = true;
+        else if(strcmp(argv[i], "--packed") == 0)
+            options.keep_rounds = true;
+        else if(strcmp(argv[i], "--shapes") == 0 && i + 1 < argc && parse_int(string_view(argv[i + 1]), num_shapes))
+            i++;
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc && parse_int(string_view(argv[i + 1]), options.num_threads))
+            i++;
+        else
+            return usage(argv[0]);
+    }
+    if((options.use_simd || options.keep_rounds) && num_shapes != PuzzleRules::SHAPES)
+        return usage(argv[0]);
+    if(options.use_simd + options.use_stream + options.keep_rounds > 1)
+        return usage(argv[0]);
+    if((options.use_stream || options.keep_rounds) && options.num_threads != 1) // single reads of the file
+        return usage(argv[0]);
+
+    if(num_shapes != 3 && num_shapes != 5 && num_shapes != 7)
+        return usage(argv[0]);
+    uint64_t scores[2];
+    try
+    {
+        if(num_shapes == 3)
+            score_file<3>("input.txt", part, options, scores);
+        else if(num_shapes == 5)
+            score_file<5>("input.txt", part, options, scores);
+        else
+            score_file<7>("input.txt", part, options, scores);
+    }
+    catch(const exception& e)
+    {
+        // an invalid line, or a round the N shape part two can not score
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    for(int current_part = 1; current_part <= 2; current_part++)
     {
-        score += calculate_round_score(rounds.at(i).player_move, rounds.at(i).opponent_move);
+        if(should_run_part(part, current_part))
+            cout << "score: " << scores[current_part - 1] << endl;
     }
-    cout << "score: " << score << endl;
+    PERF_REPORT();
 }
+#endif
@@ -0,0 +1,112 @@
+#ifndef GROUP_INTERSECTOR_H
+#define GROUP_INTERSECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "item_mask.h"
+
+/*
+N-way intersection of rucksacks: every G consecutive lines form a group, every line is split
+into S equal parts, and the common items of the group are the AND of the G * S item masks.
+part 1 is G = 1, S = 2 (the halves of a line), part 2 is G = 3, S = 1 (the badge of 3 elves).
+
+lines are streamed in one at a time, the engine only keeps the mask of the open group,
+so any group size runs in one pass and constant memory.
+the priority of a group is the sum of the priorities of its common items (the puzzle has
+exactly one), a group with no common item has priority 0 and an empty mask.
+a line is trimmed before it is split, the items that do not fill a whole part are ignored.
+*/
+
+static inline std::string_view rucksack_trim(std::string_view str, std::string_view whitespace = " \t\n\r")
+{
+    const auto str_begin = str.find_first_not_of(whitespace);
+    if(str_begin == std::string_view::npos)
+        return ""; // no content
+    const auto str_end = str.find_last_not_of(whitespace);
+    return str.substr(str_begin, str_end - str_begin + 1);
+}
+
+/*
+item mask (item_mask.h) of items, throws std::invalid_argument if one of them is not an item
+end is the end of the buffer the items are in, the vectorized builder may read up to it
+*/
+static inline uint64_t rucksack_item_mask(std::string_view items, const char* end, bool use_simd)
+{
+    // bit 0 flags an invalid item, so the loops are free of branches
+    uint64_t mask = use_simd ? item_mask(items.data(), items.length(), end)
+                             : item_mask_scalar(items.data(), items.length());
+    if(mask & ITEM_MASK_INVALID_BIT)
+    {
+        for(char item : items)
+        {
+            if(!item_priority(item))
+                throw std::invalid_argument("rucksack_item_mask(): invalid item: " + std::string(1, item));
+        }
+    }
+    return mask;
+}
+
+// sum of the priorities of the items of mask
+static inline uint32_t item_mask_priority_sum(uint64_t mask)
+{
+    uint32_t sum = 0;
+    for(; mask; mask &= mask - 1)
+        sum += __builtin_ctzll(mask);
+    return sum;
+}
+
+typedef struct
+{
+    uint64_t common;       // the items shared by every part of every line of the group
+    uint32_t priority_sum; // of the common items
+} group_result_s;
+
+class GroupIntersector
+{
+private:
+    size_t m_group_size;
+    size_t m_split_count;
+    bool m_use_simd;
+    uint64_t m_common = ~0ULL;
+    size_t m_pending_lines = 0; // lines of the open group
+    uint64_t m_num_groups = 0;
+    uint64_t m_priority_sum = 0;
+public:
+    GroupIntersector(size_t group_size, size_t split_count, bool use_simd = false)
+        : m_group_size(group_size), m_split_count(split_count), m_use_simd(use_simd)
+    {
+        if(group_size == 0 || split_count == 0)
+            throw std::invalid_argument("GroupIntersector: the group size and the split count must be positive");
+    }
+
+    /*
+    add the next line (a span of a buffer that ends at end), returns true if it closed a group,
+    whose common items and priority are then written to result
+    */
+    bool add_line(std::string_view line, const char* end, group_result_s& result)
+    {
+        line = rucksack_trim(line);
+        size_t part_length = line.length() / m_split_count;
+        for(size_t part = 0; part < m_split_count; part++)
+            m_common &= rucksack_item_mask(line.substr(part * part_length, part_length), end, m_use_simd);
+        if(++m_pending_lines < m_group_size)
+            return false;
+        result.common = m_common & ~ITEM_MASK_INVALID_BIT;
+        result.priority_sum = item_mask_priority_sum(result.common);
+        m_priority_sum += result.priority_sum;
+        m_num_groups++;
+        m_common = ~0ULL;
+        m_pending_lines = 0;
+        return true;
+    }
+
+    uint64_t num_groups() const { return m_num_groups; }
+    uint64_t priority_sum() const { return m_priority_sum; }
+    size_t pending_lines() const { return m_pending_lines; } // a complete input leaves 0
+};
+
+#endif
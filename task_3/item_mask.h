@@ -0,0 +1,145 @@
+#ifndef ITEM_MASK_H
+#define ITEM_MASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "../utils/scanner.h"
+
+/*
+the set of items of a compartment (or a rucksack) as a 64-bit mask: bit <priority> is set
+for every item, a = 1 ... z = 26, A = 27 ... Z = 52. bit 0 is never set by a valid item.
+
+the vectorized builder takes 32 items at a time:
+- the priorities come from range compares and subtracts ('a' - 1 for lowercase, 'A' - 27 for uppercase)
+- every lane is widened to 64 bits and turns into the bit 1 << priority with a variable shift (vpsllvq),
+  the bits of the 32 lanes are OR-ed together, so the loop has no data dependent branch.
+a block shorter than 32 items is padded with copies of its first item, which adds no new bit,
+it is loaded in place when the buffer goes on for 32 more bytes, and copied otherwise.
+it is picked with the scanner's cpuid dispatch (vpsllvq needs AVX2), with a scalar fallback.
+every builder reports whether all the items were valid, the callers decide how to fail.
+*/
+
+#define ITEM_MASK_INVALID_BIT 1ULL // bit 0, set by any byte that is not an item
+
+/*
+priority of every byte, 0 for the bytes that are not items
+*/
+struct ItemPriorityTable
+{
+    uint8_t priorities[256] = {0};
+
+    constexpr ItemPriorityTable()
+    {
+        for(char letter = 'a'; letter <= 'z'; letter++)
+            priorities[static_cast<uint8_t>(letter)] = (letter - 'a') + 1;
+        for(char letter = 'A'; letter <= 'Z'; letter++)
+            priorities[static_cast<uint8_t>(letter)] = (letter - 'A') + 27;
+    }
+};
+
+constexpr ItemPriorityTable ITEM_PRIORITY_TABLE;
+
+static inline uint8_t item_priority(char item)
+{
+    return ITEM_PRIORITY_TABLE.priorities[static_cast<uint8_t>(item)];
+}
+
+// one table lookup per item, bit 0 of the result is set if an item was invalid
+static inline uint64_t item_mask_scalar(const char* items, size_t length)
+{
+    uint64_t mask = 0;
+    for(size_t i = 0; i < length; i++)
+        mask |= 1ULL << item_priority(items[i]);
+    return mask;
+}
+
+#ifdef SCANNER_X86
+
+/*
+bit <priority> of every valid lane of block, bit 0 for the invalid ones
+*/
+SCANNER_TARGET("avx2")
+static inline uint64_t item_mask_block_avx2(__m256i block)
+{
+    // signed compares, the letters are all below 0x80 and the other bytes are rejected anyway
+    __m256i is_lower = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('a' - 1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), block));
+    __m256i is_upper = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('A' - 1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), block));
+    __m256i lower = _mm256_and_si256(is_lower, _mm256_sub_epi8(block, _mm256_set1_epi8('a' - 1)));
+    __m256i upper = _mm256_and_si256(is_upper, _mm256_sub_epi8(block, _mm256_set1_epi8('A' - 27)));
+    __m256i priorities = _mm256_or_si256(lower, upper); // 0 for the invalid lanes
+
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m128i halves[2] = {_mm256_castsi256_si128(priorities), _mm256_extracti128_si256(priorities, 1)};
+    __m256i bits = _mm256_setzero_si256();
+    for(__m128i half : halves)
+    {
+        // 4 priorities at a time, one per 64-bit lane
+        bits = _mm256_or_si256(bits, _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(half)));
+        bits = _mm256_or_si256(bits, _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(_mm_srli_si128(half, 4))));
+        bits = _mm256_or_si256(bits, _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(_mm_srli_si128(half, 8))));
+        bits = _mm256_or_si256(bits, _mm256_sllv_epi64(one, _mm256_cvtepu8_epi64(_mm_srli_si128(half, 12))));
+    }
+    __m128i folded = _mm_or_si128(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+    folded = _mm_or_si128(folded, _mm_unpackhi_epi64(folded, folded));
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(folded));
+}
+
+/*
+bit 0 of the result is set if an item was invalid
+[items, end) must be readable, when at least 32 bytes are the last block is loaded in place
+and its lanes past length are replaced, otherwise it is copied
+*/
+SCANNER_TARGET("avx2")
+static inline uint64_t item_mask_avx2(const char* items, size_t length, const char* end)
+{
+    uint64_t mask = 0;
+    size_t pos = 0;
+    for(; pos + 32 <= length; pos += 32)
+        mask |= item_mask_block_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(items + pos)));
+    if(pos < length)
+    {
+        // the padding lanes repeat an item of the block, so they neither add an item nor hide an invalid one
+        size_t remaining = length - pos;
+        __m256i padding = _mm256_set1_epi8(items[pos]);
+        __m256i block;
+        if(end - (items + pos) >= 32)
+        {
+            // lanes below remaining are all ones: a 32 byte window into 32 ones followed by 32 zeros
+            static const int8_t WINDOW[64] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                              -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+            __m256i is_item = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(WINDOW + 32 - remaining));
+            block = _mm256_blendv_epi8(padding, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(items + pos)), is_item);
+        }
+        else
+        {
+            alignas(32) char copy[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(copy), padding);
+            memcpy(copy, items + pos, remaining);
+            block = _mm256_load_si256(reinterpret_cast<const __m256i*>(copy));
+        }
+        mask |= item_mask_block_avx2(block);
+    }
+    return mask;
+}
+
+#endif // SCANNER_X86
+
+/*
+[items, end) must be readable, end is the end of the whole buffer (at least items + length)
+*/
+static inline uint64_t item_mask(const char* items, size_t length, const char* end)
+{
+#ifdef SCANNER_X86
+    if(scan_detect_isa() == SCAN_ISA_AVX2)
+        return item_mask_avx2(items, length, end);
+#else
+    (void)end;
+#endif
+    return item_mask_scalar(items, length);
+}
+
+#endif
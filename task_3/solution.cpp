@@ -11,124 +11,267 @@ sum the priorities of each common item
 
 #include <iostream>
 #include <algorithm>
-#include <fstream>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "../utils/alloc_stats.h"
+#include "../utils/line_ranges.h"
+#include "../utils/mapped_file.h"
+#include "../utils/parse_int.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
+#include "../utils/thread_pool.h"
+#include "group_intersector.h"
+
 using namespace std;
 
-#define HISTOGRAM_SIZE 53
+MappedFile load_file(string path)
+{
+    return MappedFile(path);
+}
 
-vector<string> load_file(string path)
+/*
+the whole pipeline works on std::string_view spans of the mapped input, so scoring a line does
+not allocate (build with -DALLOC_STATS to see the counts, utils/alloc_stats.h)
+
+both parts are group intersections (group_intersector.h): part 1 is groups of 1 line split in
+2 halves, part 2 groups of 3 lines that are not split.
+require_common throws if a group has no common item (the puzzle always has one)
+*/
+typedef struct
 {
-    fstream fp;
-    fp.open(path, ios::in);
-    string line;
-    vector<string> lines;
-    while(getline(fp, line))
+    size_t group_size;
+    size_t split_count;
+    bool require_common;
+} group_query_s;
+
+const group_query_s PART_ONE_QUERY = {1, 2, true};
+const group_query_s PART_TWO_QUERY = {3, 1, true};
+const size_t MAX_GROUP_QUERIES = 2;
+
+/*
+answers up to MAX_GROUP_QUERIES queries in a single pass over the lines of range, whole lines
+of a buffer that ends at end, the sum of the group priorities of query i goes to sums[i].
+first_line is the index of the first line of range in the input, a multiple of every group size.
+print_groups writes the priority of every group of the first query to stdout
+*/
+void intersect_range(string_view range, const char* end, uint64_t first_line, const group_query_s* queries, size_t num_queries,
+                     bool use_simd, bool print_groups, uint64_t* sums)
+{
+    optional<GroupIntersector> intersectors[MAX_GROUP_QUERIES]; // no allocation per range
+    for(size_t i = 0; i < num_queries; i++)
+        intersectors[i].emplace(queries[i].group_size, queries[i].split_count, use_simd);
+    group_result_s group;
+    for(string_view line : MappedFile::LineRange(range.data(), range.data() + range.size()))
+    {
+        for(size_t i = 0; i < num_queries; i++)
+        {
+            if(!intersectors[i]->add_line(line, end, group))
+                continue;
+            uint64_t group_index = first_line / queries[i].group_size + intersectors[i]->num_groups();
+            if(queries[i].require_common && !group.common)
+            {
+                throw invalid_argument("intersect_range(): no common item in group " + to_string(group_index));
+            }
+            if(print_groups && i == 0)
+                cout << "group " << group_index << ": " << group.priority_sum << "\n";
+        }
+    }
+    for(size_t i = 0; i < num_queries; i++)
     {
-        lines.push_back(line);
+        if(intersectors[i]->pending_lines())
+        {
+            throw invalid_argument("intersect_range(): the last group has " + to_string(intersectors[i]->pending_lines()) + " rucksacks");
+        }
+        sums[i] = intersectors[i]->priority_sum();
     }
-    return lines;
 }
 
-uint32_t get_priority(char letter)
+uint64_t get_group_priority_sum(const MappedFile& lines, const group_query_s& query, bool use_simd = false, bool print_groups = false)
 {
-    uint32_t priority = 0;
-    if(letter >= 'a' && letter <= 'z')
-        priority = (letter - 'a') + 1;
-    else if(letter >= 'A' && letter <= 'Z')
-        priority = (letter - 'A') + 27;
-    else
+    uint64_t sum;
+    intersect_range(lines.data(), lines.data().data() + lines.size(), 0, &query, 1, use_simd, print_groups, &sum);
+    return sum;
+}
+
+/*
+parallel mode: the mapped file is cut into one range of whole groups per worker (the cuts are
+on multiples of every group size, utils/line_ranges.h), every worker answers all the queries
+over its range in one pass and the sums are added up in the calling thread
+*/
+void get_group_priority_sums_parallel(const MappedFile& lines, const group_query_s* queries, size_t num_queries, bool use_simd,
+                                      size_t num_threads, uint64_t* sums)
+{
+    string_view data = lines.data();
+    const char* end = data.data() + data.size();
+    size_t alignment = 1;
+    for(size_t i = 0; i < num_queries; i++)
+        alignment = lcm(alignment, queries[i].group_size);
+    ThreadPool pool(num_threads);
+    size_t num_ranges = count_line_ranges(data.size(), pool);
+    vector<future<array<uint64_t, MAX_GROUP_QUERIES>>> futures;
+    for(const line_range_s& range : split_on_line_groups(data, num_ranges, alignment, pool))
     {
-        cout << "INVALID PARAMETER: " << letter << endl;
-        throw;
+        futures.push_back(pool.submit([range, end, queries, num_queries, use_simd] {
+            array<uint64_t, MAX_GROUP_QUERIES> partial;
+            intersect_range(range.data, end, range.first_line, queries, num_queries, use_simd, false, partial.data());
+            return partial;
+        }));
+    }
+    fill(sums, sums + num_queries, 0);
+    for(auto& partial : futures)
+    {
+        array<uint64_t, MAX_GROUP_QUERIES> sum = partial.get();
+        for(size_t i = 0; i < num_queries; i++)
+            sums[i] += sum[i];
     }
-    return priority;
 }
 
+uint64_t get_priority_sum_part1(const MappedFile& lines, bool use_simd = false)
+{
+    return get_group_priority_sum(lines, PART_ONE_QUERY, use_simd);
+}
 
-string trim(const string& str, const string& whitespace = " \t\n\r")
+uint64_t get_priority_sum_part2(const MappedFile& lines, bool use_simd = false)
 {
-    const auto str_begin = str.find_first_not_of(whitespace);
+    return get_group_priority_sum(lines, PART_TWO_QUERY, use_simd);
+}
 
-    if (str_begin == string::npos)
-        return ""; // no content
+static void* solver_parse(const char* input_path)
+{
+    return new MappedFile(load_file(input_path));
+}
 
-    const auto str_end = str.find_last_not_of(whitespace);
-    const auto str_length = str_end - str_begin + 1;
+static bool solver_part1(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, get_priority_sum_part1(*static_cast<MappedFile*>(state)));
+}
 
-    return str.substr(str_begin, str_length);
+static bool solver_part2(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, get_priority_sum_part2(*static_cast<MappedFile*>(state)));
 }
 
-uint32_t get_common_letter_priority(string line1, string line2, string line3 = "")
+static void solver_release(void* state)
 {
-    // create 2 histogram arrays instead of iterating the strings in 2 for loops - o(n) instead of o(n^2)
-    bool letter_histogram1[HISTOGRAM_SIZE] = {0}, letter_histogram2[HISTOGRAM_SIZE] = {0}, letter_histogram3[HISTOGRAM_SIZE] = {0};
-    // fill the histograms
-    // treat the letter priority like an index in the array [index 0 will not be used]
-
-    line1 = trim(line1);
-    line2 = trim(line2);
-    line3 = trim(line3);
-    for(uint32_t i = 0; i < line1.length(); i++)
-    {
-        uint32_t histogram_index = get_priority(line1.at(i));
-        letter_histogram1[histogram_index] = true;
-    }
-    for(uint32_t i = 0; i < line2.length(); i++)
-    {
-        uint32_t histogram_index = get_priority(line2.at(i));
-        letter_histogram2[histogram_index] = true;
-    }
-    for(uint32_t i = 0; i < line3.length(); i++)
-    {
-        uint32_t histogram_index = get_priority(line3.at(i));
-        letter_histogram3[histogram_index] = true;
-    }
-    // find the common priority and return it
-    for(uint32_t i = 0; i < HISTOGRAM_SIZE; i++)
-    {
-        if(letter_histogram1[i] && letter_histogram2[i] && (line3.length() == 0 || letter_histogram3[i]))
-            return i;
-    }
-    cout << "NO COMMON CHARACTER FOUND!" << endl;
-    throw;
+    delete static_cast<MappedFile*>(state);
 }
 
-uint32_t get_priority_sum_part1(vector<string> lines)
+extern "C" const solver_t task_3_solver = {"task_3", solver_parse, solver_part1, solver_part2, solver_release};
+
+#ifndef AOC_RUNNER
+int usage(const char* name)
 {
-    string first, second;
-    uint32_t sum = 0;
-    for(uint32_t i = 0; i < lines.size(); i++)
-    {
-        // split to 2 halves
-        uint32_t half_length = (lines.at(i).length() / 2);
-        first  = lines.at(i).substr(0, half_length);
-        second = lines.at(i).substr(half_length, half_length);
-
-        // get the priority
-        uint32_t priority = get_common_letter_priority(first, second);
-        sum += priority;
-    }
-    return sum;
+    cerr << "usage: " << name << " [1|2] [--simd] [--threads N] | --group G --split S [--per-group] [--simd] [--threads N]" << endl;
+    return 1;
 }
 
-uint32_t get_priority_sum_part2(vector<string> lines)
+/*
+solution [1|2] [--simd] [--threads N] | --group G --split S [--per-group] [--simd] [--threads N]
+--simd        builds the item masks with the vectorized kernel (item_mask.h) instead of the table lookup loop
+--group G     instead of the parts, sums the priorities of the common items of every G lines,
+--split S     each of them split in S parts (part 1 is --group 1 --split 2, part 2 --group 3 --split 1),
+              a group may have no common item
+--per-group   also prints the priority of every group (single pass only)
+--threads N   splits the file between N workers (0 = one per hardware thread), that score both
+              parts in one pass, the default is a single pass per part
+*/
+int main(int argc, char* argv[])
 {
-    uint32_t sum = 0;
-    for(uint32_t i = 0; i < lines.size(); i+=3)
+    bool has_part_arg = (argc > 1 && strncmp(argv[1], "--", 2) != 0);
+    int part = has_part_arg ? parse_part_arg(argc, argv) : PART_BOTH;
+    if(part == PART_INVALID)
+        return 1;
+    bool use_simd = false;
+    bool print_groups = false;
+    size_t num_threads = 1;
+    group_query_s query = {0, 0, false}; // a group size of 0 runs the puzzle parts
+    for(int i = has_part_arg ? 2 : 1; i < argc; i++)
     {
-        sum += get_common_letter_priority(lines.at(i), lines.at(i+1), lines.at(i+2));
+        if(strcmp(argv[i], "--simd") == 0)
+            use_simd = true;
+        else if(strcmp(argv[i], "--per-group") == 0)
+            print_groups = true;
+        else if(strcmp(argv[i], "--group") == 0 && i + 1 < argc && parse_int(string_view(argv[i + 1]), query.group_size) && query.group_size)
+            i++;
+        else if(strcmp(argv[i], "--split") == 0 && i + 1 < argc && parse_int(string_view(argv[i + 1]), query.split_count) && query.split_count)
+            i++;
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc && parse_int(string_view(argv[i + 1]), num_threads))
+            i++;
+        else
+            return usage(argv[0]);
     }
-    return sum;
-}
+    bool is_query = query.group_size || query.split_count;
+    if(is_query && (has_part_arg || !query.group_size || !query.split_count))
+        return usage(argv[0]);
+    if(print_groups && (!is_query || num_threads != 1))
+        return usage(argv[0]);
 
-int main()
-{
-    vector<string> lines = load_file("input.txt");
-    //uint32_t sum1 = get_priority_sum_part1(lines);
-    //cout << "part 1:" << sum1 << endl;
-    uint32_t sum2 = get_priority_sum_part2(lines);
-    cout << "part 2:" << sum2 << endl;
-}
\ No newline at end of file
+    try
+    {
+        PERF_BEGIN(read, "read");
+        MappedFile lines = load_file("input.txt");
+        lines.prefault();
+        PERF_END(read);
+        if(is_query)
+        {
+            PERF_SCOPE("groups: parse+solve");
+            uint64_t sum;
+            if(num_threads == 1)
+                sum = get_group_priority_sum(lines, query, use_simd, print_groups);
+            else
+                get_group_priority_sums_parallel(lines, &query, 1, use_simd, num_threads, &sum);
+            cout << "sum:" << sum << endl;
+        }
+        else if(num_threads != 1)
+        {
+            uint64_t sums[2];
+            {
+                PERF_SCOPE("parse+solve both parts (parallel)");
+                const group_query_s queries[2] = {PART_ONE_QUERY, PART_TWO_QUERY};
+                get_group_priority_sums_parallel(lines, queries, 2, use_simd, num_threads, sums);
+            }
+            for(int current_part = 1; current_part <= 2; current_part++)
+            {
+                if(should_run_part(part, current_part))
+                    cout << "part " << current_part << ":" << sums[current_part - 1] << endl;
+            }
+        }
+        else
+        {
+            if(should_run_part(part, 1))
+            {
+                PERF_SCOPE("part 1: parse+solve"); // the halves are split while they are scored
+                ALLOC_STATS_BEGIN(part1);
+                uint64_t sum1 = get_priority_sum_part1(lines, use_simd);
+                ALLOC_STATS_END(part1, "part 1");
+                cout << "part 1:" << sum1 << endl;
+            }
+            if(should_run_part(part, 2))
+            {
+                PERF_SCOPE("part 2: parse+solve");
+                ALLOC_STATS_BEGIN(part2);
+                uint64_t sum2 = get_priority_sum_part2(lines, use_simd);
+                ALLOC_STATS_END(part2, "part 2");
+                cout << "part 2:" << sum2 << endl;
+            }
+        }
+    }
+    catch(const exception& e)
+    {
+        // a missing input, an invalid item, a group without a common item or an incomplete last group
+        cerr << e.what() << endl;
+        return 1;
+    }
+    PERF_REPORT();
+}
+#endif
@@ -1,26 +1,23 @@
 #include <iostream>
-#include <fstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
-using namespace std;
+#include "../utils/mapped_file.h"
+#include "../utils/scanner.h"
+#include "../utils/parse_int.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
 
-std::vector<std::string> readlines(std::fstream& fp)
-{    
-    std::vector<std::string> lines;
-    std::string line;
-    while(getline(fp, line))
-    {
-        lines.push_back(line);
-    }
-    return lines;
-}
+using namespace std;
 
-std::string trim_whitespaces(const std::string& str, const std::string& whitespace = " \t\n\r")
+string_view trim_whitespaces(string_view str, string_view whitespace = " \t\n\r")
 {
     const auto str_begin = str.find_first_not_of(whitespace);
 
-    if (str_begin == std::string::npos)
+    if (str_begin == string_view::npos)
         return ""; // no content
 
     const auto str_end = str.find_last_not_of(whitespace);
@@ -31,43 +28,32 @@ std::string trim_whitespaces(const std::string& str, const std::string& whitespa
 
 typedef pair<uint32_t, uint32_t> range_s;
 typedef pair<range_s, range_s> line_data_s;
-typedef pair<string, string> split_line_s;
 
-split_line_s split_string(string line, char sep)
+/*
+"8-98" to (8, 98), fields is a scratch vector reused between the calls
+*/
+range_s get_range(string_view text, vector<string_view>& fields)
 {
-    uint32_t sep_index = line.find_first_of(sep);
-
-    if(sep_index == string::npos)
+    split_fields(trim_whitespaces(text), '-', fields);
+    if(fields.size() != 2)
     {
-        return split_line_s(line, "");
+        throw invalid_argument("get_range(): invalid range: " + string(text));
     }
-
-    uint32_t part1_len = sep_index, part1_begin = 0;
-    uint32_t part2_len = line.length() - (sep_index + 1), part2_begin = (sep_index + 1);
-    string part1 = line.substr(part1_begin, part1_len);
-    string part2 = line.substr(part2_begin, part2_len);
-
-    return split_line_s(part1, part2);
+    return range_s(parse_number<uint32_t>(fields[0]), parse_number<uint32_t>(fields[1]));
 }
 
-line_data_s get_line_data(const string& line)
+line_data_s get_line_data(string_view line)
 {
-    string line_copy;
-    line_copy = trim_whitespaces(line);
     // example: 8-98,7-97
-    // split line to 2 substrings
-    split_line_s comma_split = split_string(line_copy, ',');
-
-    // split each part 
-    split_line_s part1_split = split_string(comma_split.first, '-');
-    split_line_s part2_split = split_string(comma_split.second, '-');
-    
-    // string to int
-    line_data_s result;
-    result.first  = range_s(stoi(part1_split.first), stoi(part1_split.second));
-    result.second = range_s(stoi(part2_split.first), stoi(part2_split.second));
-
-    return result;
+    vector<string_view> fields;
+    split_fields(trim_whitespaces(line), ',', fields);
+    if(fields.size() != 2)
+    {
+        throw invalid_argument("get_line_data(): invalid line: " + string(line));
+    }
+    string_view second = fields[1]; // get_range() reuses fields
+    range_s first = get_range(fields[0], fields);
+    return line_data_s(first, get_range(second, fields));
 }
 
 bool are_groups_overlapping(line_data_s ranges, bool full_overlap_only = true)
@@ -91,25 +77,81 @@ bool are_groups_overlapping(line_data_s ranges, bool full_overlap_only = true)
     }
 }
 
-int main()
+/*
+the newlines and the commas of the whole file are found in one pass (ScanIndex, utils/scanner.h),
+the comma of every line then comes from the index instead of a search
+*/
+uint32_t count_overlapping_pairs(const MappedFile& lines, bool full_overlap_only)
 {
-    fstream fp;
-    fp.open("input.txt", ios::in);
-    vector<string> lines = readlines(fp);
-    for(uint32_t part = 0; part < 2; part++)
+    PERF_SCOPE(full_overlap_only ? "part 1: parse+solve" : "part 2: parse+solve"); // every line is parsed and checked in one go
+    string_view data = lines.data();
+    ScanIndex index(data, ',');
+    vector<string_view> fields;
+    uint32_t counter = 0;
+    size_t begin = 0;
+    size_t comma = 0; // first comma of the current line in index.delims
+    for(size_t line = 0; begin < data.size(); line++)
     {
-        cout << "part " << part + 1 << ", count = ";
-        uint32_t counter = 0;
-        bool full_overlap_flag = (part == 0);
-        for(uint32_t i = 0; i < lines.size(); i++)
+        size_t end = (line < index.newlines.count) ? index.newlines.offsets[line] : data.size();
+        size_t line_comma = comma;
+        while(comma < index.delims.count && index.delims.offsets[comma] < end)
+            comma++;
+        if(comma - line_comma != 1)
         {
-            line_data_s data = get_line_data(lines.at(i));
-            if(are_groups_overlapping(data, full_overlap_flag))
-                counter++;
+            throw invalid_argument("count_overlapping_pairs(): invalid line: " + string(data.substr(begin, end - begin)));
         }
-        cout << counter << endl;
+        size_t sep = index.delims.offsets[line_comma];
+        range_s first = get_range(data.substr(begin, sep - begin), fields);
+        line_data_s ranges(first, get_range(data.substr(sep + 1, end - sep - 1), fields));
+        if(are_groups_overlapping(ranges, full_overlap_only))
+            counter++;
+        begin = end + 1;
+    }
+    return counter;
+}
+
+static void* solver_parse(const char* input_path)
+{
+    return new MappedFile(input_path);
+}
+
+static bool solver_part1(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, count_overlapping_pairs(*static_cast<MappedFile*>(state), true));
+}
+
+static bool solver_part2(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, count_overlapping_pairs(*static_cast<MappedFile*>(state), false));
+}
+
+static void solver_release(void* state)
+{
+    delete static_cast<MappedFile*>(state);
+}
+
+extern "C" const solver_t task_4_solver = {"task_4", solver_parse, solver_part1, solver_part2, solver_release};
+
+#ifndef AOC_RUNNER
+int main(int argc, char* argv[])
+{
+    int selected_part = parse_part_arg(argc, argv);
+    if(selected_part == PART_INVALID)
+        return 1;
+    PERF_BEGIN(read, "read");
+    MappedFile lines("input.txt");
+    lines.prefault();
+    PERF_END(read);
+    for(uint32_t part = 0; part < 2; part++)
+    {
+        if(!should_run_part(selected_part, part + 1))
+            continue;
+        cout << "part " << part + 1 << ", count = ";
+        cout << count_overlapping_pairs(lines, part == 0) << endl;
     }
+    PERF_REPORT();
 }
+#endif
 
 void test_get_line_data()
 {
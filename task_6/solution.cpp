@@ -1,27 +1,80 @@
 #include <iostream>
-#include <fstream>
 #include <string>
 
 #include "marker_buffer.h"
+#include "../utils/mapped_file.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
 
 using namespace std;
 
-int main()
+// returns the number of characters read until the marker is complete, 0 if there is no marker
+uint32_t find_marker(const MappedFile& fp, uint32_t buff_size)
 {
-    uint32_t buff_size = 14;
     MarkerCyclicBuffer<uint32_t> buffer(buff_size, false);
-    
-    fstream fp;
-    fp.open("input.txt", ios::in);
-    char ch;
     uint32_t counter = 0;
-    while (fp >> noskipws >> ch) {
+    for (char ch : fp.data()) {
         buffer.write(ch);
         counter++;
         if(counter >= buff_size && buffer.is_buffer_unique())
         {
-            printf("marker found to be unique after character number %d\n", counter);
-            break;
+            return counter;
         }
     }
-}
\ No newline at end of file
+    return 0;
+}
+
+void print_marker(uint32_t marker)
+{
+    if(marker)
+        printf("marker found to be unique after character number %d\n", marker);
+}
+
+static void* solver_parse(const char* input_path)
+{
+    return new MappedFile(input_path);
+}
+
+static bool solver_part1(void* state, char* answer, size_t answer_size)
+{
+    uint32_t marker = find_marker(*static_cast<MappedFile*>(state), 4);
+    return marker && solver_answer_u64(answer, answer_size, marker);
+}
+
+static bool solver_part2(void* state, char* answer, size_t answer_size)
+{
+    uint32_t marker = find_marker(*static_cast<MappedFile*>(state), 14);
+    return marker && solver_answer_u64(answer, answer_size, marker);
+}
+
+static void solver_release(void* state)
+{
+    delete static_cast<MappedFile*>(state);
+}
+
+extern "C" const solver_t task_6_solver = {"task_6", solver_parse, solver_part1, solver_part2, solver_release};
+
+#ifndef AOC_RUNNER
+int main(int argc, char* argv[])
+{
+    int part = parse_part_arg(argc, argv);
+    if(part == PART_INVALID)
+        return 1;
+    PERF_BEGIN(read, "read");
+    MappedFile fp("input.txt");
+    fp.prefault();
+    PERF_END(read);
+    if(should_run_part(part, 1))
+    {
+        PERF_SCOPE("part 1: solve"); // there is nothing to parse, the stream is scanned as is
+        print_marker(find_marker(fp, 4));  // start of packet marker
+    }
+    if(should_run_part(part, 2))
+    {
+        PERF_SCOPE("part 2: solve");
+        print_marker(find_marker(fp, 14)); // start of message marker
+    }
+    PERF_REPORT();
+}
+#endif
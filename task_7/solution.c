@@ -5,11 +5,20 @@
 #include <stdint.h>
 #include <assert.h>
 
+#include "../utils/scanner.h"
+#include "../utils/parse_int.h"
+#include "../utils/arena.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
+#include "../utils/parse_cache.h"
+
 #define STR_BUF_LEN(x) (strlen(x) + 1)
 #define MAX_LINE 60
 #define TASK1_MAX_SIZE 100000
 #define DISK_SIZE 70000000
 #define UPDATE_SIZE 30000000
+#define FS_CACHE_FORMAT 1 // layout of fs_payload_header_t, fs_record_t and the names
 
 typedef enum
 {
@@ -52,6 +61,7 @@ typedef struct
 {
     inode* root_folder;
     inode* current_folder;
+    arena_t scratch; // per line allocations, released in one shot by release_fs_scratch()
 } file_system;
 
 res_status_e validate_folder(inode* folder)
@@ -318,10 +328,43 @@ file_system* init_fs()
 
     fs->root_folder = root_dir;
     fs->current_folder = root_dir; // start from root;
+    arena_init(&fs->scratch, ARENA_DEFAULT_CHUNK_SIZE);
 
     return fs;
 }
 
+void release_fs_scratch(file_system* fs)
+{
+#ifdef ARENA_STATS
+    arena_print_stats(&fs->scratch, "task_7 scratch", stderr);
+#endif
+    arena_release(&fs->scratch);
+}
+
+void free_inode(inode* node)
+{
+    if(node->file_type == TYPE_DIR)
+    {
+        // links only point back at the parent, the parent is freed by its own parent
+        for(uint32_t index = 0; index < node->dir_md->num_files; index++)
+            free_inode(node->dir_md->files_list[index]);
+        free(node->dir_md->files_list);
+        free(node->dir_md);
+    }
+    free(node->name);
+    free(node);
+}
+
+/*
+free the whole tree and the file system itself
+*/
+void release_fs(file_system* fs)
+{
+    release_fs_scratch(fs);
+    free_inode(fs->root_folder);
+    free(fs);
+}
+
 res_status_e change_dir(file_system* fs, char* next_dir_name)
 {
     if(!fs || !next_dir_name)
@@ -364,6 +407,25 @@ res_status_e change_dir(file_system* fs, char* next_dir_name)
     return NOT_FOUND;
 }
 
+/*
+strtok(line, " ") replacement on top of the vectorized scanner
+returns the next space separated token in line[*pos, line_len) and advances *pos, NULL when done
+empty tokens are skipped, same as strtok
+*/
+char* next_token(char* line, size_t line_len, size_t* pos)
+{
+    while(*pos < line_len)
+    {
+        char* token = line + *pos;
+        size_t token_len = scan_find_char(token, line_len - *pos, ' ');
+        token[token_len] = 0; // either the separator or the existing null terminator
+        *pos += token_len + 1;
+        if(token_len > 0)
+            return token;
+    }
+    return NULL;
+}
+
 /*
 if starts with $ it's a command
     $ ls
@@ -381,9 +443,13 @@ res_status_e process_cmd(file_system *fs, char *line)
         return INVALID_INPUT;
     }
 
-    line[strcspn(line, "\r\n")] = 0; // remove trailing newline
+    // remove trailing newline
+    size_t line_len = scan_find_char(line, strlen(line), '\n');
+    if(line_len > 0 && line[line_len - 1] == '\r')
+        line_len--;
+    line[line_len] = 0;
 
-    char* line_copy = (char*)calloc(STR_BUF_LEN(line), sizeof(char));
+    char* line_copy = (char*)arena_calloc(&fs->scratch, STR_BUF_LEN(line), sizeof(char));
     if(!line_copy)
     {
         printf("process_cmd(): error allocating memory\n");
@@ -395,7 +461,8 @@ res_status_e process_cmd(file_system *fs, char *line)
     file_type_e file_type = TYPE_FILE;
     uint32_t token_index = 0;
     uint32_t file_size = 0;
-    char* token = strtok(line_copy, " ");
+    size_t token_pos = 0;
+    char* token = next_token(line_copy, line_len, &token_pos);
     while(token != NULL)
     {
         switch(token_index)
@@ -412,7 +479,11 @@ res_status_e process_cmd(file_system *fs, char *line)
                 else
                 {
                     file_type = TYPE_FILE;
-                    file_size = (uint32_t)atoi(token);
+                    if(!parse_uint32(token, token + strlen(token), &file_size))
+                    {
+                        printf("process_cmd(): invalid file size: %s\n", token);
+                        return INVALID_INPUT;
+                    }
                 }
                 break;
             case 1:
@@ -455,7 +526,7 @@ res_status_e process_cmd(file_system *fs, char *line)
             default:
                 break; // do nothing
         }
-        token = strtok(NULL, " ");
+        token = next_token(line_copy, line_len, &token_pos);
         token_index++;
     }
     return SUCCESS;
@@ -465,7 +536,7 @@ res_status_e process_cmd(file_system *fs, char *line)
 reads input file and build the file system tree
 will return NULL on failure
 */
-file_system* process_input(char* file_path)
+file_system* process_input(const char* file_path)
 {
     file_system* fs = init_fs();
 
@@ -492,8 +563,164 @@ file_system* process_input(char* file_path)
         if(status != SUCCESS)
         {
             printf("error code %u while processing cmd: %s\n", status, line);
+            fclose(fp);
+            release_fs(fs);
+            return NULL;
+        }
+    }
+    fclose(fp);
+    return fs;
+}
+
+/*
+cache payload: the tree flattened in pre-order (a parent always comes before its children),
+followed by the NUL terminated names. the ".." links are not stored, add_file_to_dir() rebuilds them.
+*/
+typedef struct
+{
+    uint32_t num_records;
+    uint32_t names_size;
+} fs_payload_header_t;
+
+typedef struct
+{
+    uint32_t parent;      // record index, unused by the root (record 0)
+    uint32_t file_type;   // TYPE_FILE or TYPE_DIR
+    uint32_t file_size;   // TYPE_FILE only
+    uint32_t name_offset; // into the names
+} fs_record_t;
+
+void measure_inode(inode* node, uint32_t* num_records, uint32_t* names_size)
+{
+    (*num_records)++;
+    *names_size += STR_BUF_LEN(node->name);
+    if(node->file_type != TYPE_DIR)
+        return;
+    for(uint32_t index = 0; index < node->dir_md->num_files; index++)
+    {
+        inode* child = node->dir_md->files_list[index];
+        if(child->file_type != TYPE_LINK)
+            measure_inode(child, num_records, names_size);
+    }
+}
+
+void flatten_inode(inode* node, uint32_t parent, fs_record_t* records, char* names, fs_payload_header_t* header)
+{
+    uint32_t record_index = header->num_records++;
+    fs_record_t* record = &records[record_index];
+    record->parent = parent;
+    record->file_type = node->file_type;
+    record->file_size = (node->file_type == TYPE_FILE) ? node->file_size : 0;
+    record->name_offset = header->names_size;
+    strcpy(names + header->names_size, node->name);
+    header->names_size += STR_BUF_LEN(node->name);
+    if(node->file_type != TYPE_DIR)
+        return;
+    for(uint32_t index = 0; index < node->dir_md->num_files; index++)
+    {
+        inode* child = node->dir_md->files_list[index];
+        if(child->file_type != TYPE_LINK)
+            flatten_inode(child, record_index, records, names, header);
+    }
+}
+
+/*
+returns a malloc-ed payload (NULL on failure), payload_size gets its size
+*/
+void* serialize_fs(file_system* fs, size_t* payload_size)
+{
+    uint32_t num_records = 0, names_size = 0;
+    measure_inode(fs->root_folder, &num_records, &names_size);
+    *payload_size = sizeof(fs_payload_header_t) + num_records * sizeof(fs_record_t) + names_size;
+    fs_payload_header_t* header = (fs_payload_header_t*)malloc(*payload_size);
+    if(!header)
+        return NULL;
+    fs_record_t* records = (fs_record_t*)(header + 1);
+    char* names = (char*)(records + num_records);
+    header->num_records = 0;
+    header->names_size = 0;
+    flatten_inode(fs->root_folder, 0, records, names, header);
+    return header;
+}
+
+/*
+rebuild the tree from a cache payload, NULL if the payload is not valid
+*/
+file_system* deserialize_fs(const void* payload, size_t payload_size)
+{
+    const fs_payload_header_t* header = (const fs_payload_header_t*)payload;
+    if(payload_size < sizeof(fs_payload_header_t) || header->num_records == 0
+       || payload_size != sizeof(fs_payload_header_t) + (size_t)header->num_records * sizeof(fs_record_t) + header->names_size)
+        return NULL;
+    const fs_record_t* records = (const fs_record_t*)(header + 1);
+    const char* names = (const char*)(records + header->num_records);
+    if(header->names_size == 0 || names[header->names_size - 1] != '\0')
+        return NULL;
+
+    file_system* fs = init_fs();
+    inode** nodes = (inode**)malloc(header->num_records * sizeof(inode*));
+    if(!fs || !nodes)
+    {
+        free(nodes);
+        if(fs)
+            release_fs(fs);
+        return NULL;
+    }
+    nodes[0] = fs->root_folder;
+    for(uint32_t index = 1; index < header->num_records; index++)
+    {
+        const fs_record_t* record = &records[index];
+        inode* parent = (record->parent < index) ? nodes[record->parent] : NULL;
+        inode* node = NULL;
+        if(parent && record->name_offset < header->names_size)
+        {
+            char* name = (char*)names + record->name_offset; // init_dir()/init_file() copy the name
+            node = (record->file_type == TYPE_DIR) ? init_dir(name) : init_file(name, record->file_size);
+        }
+        if(!node || add_file_to_dir(node, parent) != SUCCESS)
+        {
+            if(node)
+                free_inode(node);
+            free(nodes);
+            release_fs(fs);
             return NULL;
         }
+        nodes[index] = node;
+    }
+    free(nodes);
+    return fs;
+}
+
+/*
+process_input() behind the parse cache: a warm run rebuilds the tree from the cached records
+instead of replaying the transcript
+*/
+file_system* load_fs(const char* file_path)
+{
+    PERF_BEGIN(lookup, "cache lookup");
+    parse_cache_key_t key;
+    bool has_key = parse_cache_key_file(file_path, &key);
+    parse_cache_entry_t entry = PARSE_CACHE_ENTRY_INITIALIZER;
+    file_system* fs = NULL;
+    if(has_key && parse_cache_load(file_path, "task_7", FS_CACHE_FORMAT, &key, &entry))
+    {
+        fs = deserialize_fs(entry.payload, entry.payload_size);
+        parse_cache_close(&entry);
+    }
+    PERF_END(lookup);
+    if(fs)
+        return fs;
+
+    PERF_BEGIN(parse, "read+parse"); // the transcript is replayed line by line while it is read
+    fs = process_input(file_path);
+    PERF_END(parse);
+    if(fs && has_key)
+    {
+        size_t payload_size = 0;
+        void* payload = serialize_fs(fs, &payload_size);
+        if(payload)
+            parse_cache_store(file_path, "task_7", FS_CACHE_FORMAT, &key, payload, payload_size);
+        free(payload);
     }
     return fs;
 }
@@ -545,7 +772,11 @@ uint32_t task1(file_system* fs)
     return task1_tot_size;
 }
 
-uint32_t task2(file_system* fs)
+/*
+get the size of the smallest folder that frees enough space for the update,
+missing_size (optional) gets the space the update is missing
+*/
+uint32_t task2(file_system* fs, uint32_t* missing_size)
 {
     if(!fs)
     {
@@ -554,33 +785,76 @@ uint32_t task2(file_system* fs)
     }
 
     uint32_t root_folder_size = get_folder_size(fs->root_folder, NULL, NULL, 0);
-    uint32_t missing_size = UPDATE_SIZE - (DISK_SIZE - root_folder_size);
-    printf("space missing for update: %u\n", missing_size);
+    uint32_t task2_missing_size = UPDATE_SIZE - (DISK_SIZE - root_folder_size);
+    if(missing_size)
+        *missing_size = task2_missing_size;
 
     /*
     need to find the smallest folder that it's size is bigger than "missing_size"
     */
 
     uint32_t supremum_size = UINT32_MAX;
-    get_folder_size(fs->root_folder, NULL, &supremum_size, missing_size);
-    printf("supremum size %u\n", supremum_size);
-    return 0;
+    get_folder_size(fs->root_folder, NULL, &supremum_size, task2_missing_size);
+    return supremum_size;
+}
+
+static void* solver_parse(const char* input_path)
+{
+    return load_fs(input_path);
+}
+
+static bool solver_part1(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, task1((file_system*)state));
 }
 
-int main()
+static bool solver_part2(void* state, char* answer, size_t answer_size)
 {
-    file_system* fs = process_input("input.txt");
+    return solver_answer_u64(answer, answer_size, task2((file_system*)state, NULL));
+}
+
+static void solver_release(void* state)
+{
+    release_fs((file_system*)state);
+}
+
+const solver_t task_7_solver = {"task_7", solver_parse, solver_part1, solver_part2, solver_release};
+
+#ifndef AOC_RUNNER
+int main(int argc, char* argv[])
+{
+    int part = parse_part_arg(argc, argv);
+    if(part == PART_INVALID)
+        return 1;
+
+    file_system* fs = load_fs("input.txt");
 
     if(fs == NULL)
     {
         printf("failure!\n");
         return -1;
     }
-    uint32_t task1_tot_size = task1(fs);
-    printf("total size of folders under 100K: %u\n", task1_tot_size);
+    if(should_run_part(part, 1))
+    {
+        PERF_BEGIN(part1, "part 1: solve");
+        uint32_t task1_tot_size = task1(fs);
+        PERF_END(part1);
+        printf("total size of folders under 100K: %u\n", task1_tot_size);
+    }
 
-    task2(fs);
+    if(should_run_part(part, 2))
+    {
+        PERF_BEGIN(part2, "part 2: solve");
+        uint32_t missing_size = 0;
+        uint32_t supremum_size = task2(fs, &missing_size);
+        PERF_END(part2);
+        printf("space missing for update: %u\n", missing_size);
+        printf("supremum size %u\n", supremum_size);
+    }
+    release_fs(fs);
+    PERF_REPORT();
 }
+#endif
 
 
 int ut_1()
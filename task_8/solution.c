@@ -5,6 +5,12 @@
 #include <stdint.h>
 #include <assert.h>
 
+#include "../utils/scanner.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
+#include "../utils/parse_cache.h"
+
 /*
 part a:
 for a tree to be visible it needs to meet a criteria
@@ -37,41 +43,90 @@ strategy:
 
 #define BOARD_SIZE 99
 #define TREE_HEIGHT_OPTIONS 10
+#define BOARD_CACHE_FORMAT 1 // the payload is the int32 trees_heights board, row by row
 
-bool load_data(char* file_name, int32_t trees_heights[BOARD_SIZE][BOARD_SIZE])
+bool load_data(const char* file_name, int32_t trees_heights[BOARD_SIZE][BOARD_SIZE])
 {
-    char buffer[BOARD_SIZE + 1]; // +1 for the null terminator
+    // the whole board fits on the stack: read it in one go and index the rows with the scanner
+    char buffer[BOARD_SIZE * (BOARD_SIZE + 2) + 1]; // room for "\r\n" line endings
+    PERF_BEGIN(read, "read");
     FILE* input = fopen(file_name, "r");
     if(!input)
     {
         fprintf(stderr, "%s not found!\n", file_name);
         return false;
     }
+    size_t bytes_read = fread(buffer, 1, sizeof(buffer), input);
+    fclose(input);
+    PERF_END(read);
+    PERF_BEGIN(parse, "parse");
+
+    offset_list_t newlines = OFFSET_LIST_INITIALIZER;
+    if(!scan_buffer(buffer, bytes_read, '\n', &newlines, NULL))
+    {
+        fprintf(stderr, "Error indexing %s!\n", file_name);
+        return false;
+    }
     int32_t row = 0;
-    while(true)
+    size_t row_begin = 0;
+    for(size_t line = 0; line <= newlines.count && row_begin < bytes_read; line++)
     {
-        int32_t bytes_read = fread(buffer, 1, BOARD_SIZE + 1, input);
-        if(feof(input))
-        {
-            break;
-        }
-        if(bytes_read != BOARD_SIZE + 1)
+        size_t row_end = (line < newlines.count) ? newlines.offsets[line] : bytes_read;
+        size_t row_length = row_end - row_begin;
+        if(row_length > 0 && buffer[row_end - 1] == '\r') // remove the newline
+            row_length--;
+        if(row_length != BOARD_SIZE || row >= BOARD_SIZE)
         {
             fprintf(stderr, "Error reading %s!\n", file_name);
+            offset_list_free(&newlines);
             return false;
         }
-        buffer[strcspn(buffer, "\r\n")] = 0; // remove the newline
         for(int32_t col = 0; col < BOARD_SIZE; col++)
         {
-            //char c = ;
-            int32_t tree_height = buffer[col] - '0';
+            int32_t tree_height = buffer[row_begin + col] - '0';
             assert(tree_height >= 0 && tree_height <= 9);
             trees_heights[row][col] = tree_height;
         }
         row++;
+        row_begin = row_end + 1;
     }
+    offset_list_free(&newlines);
+    PERF_END(parse);
     assert(row == BOARD_SIZE);
-    fclose(input);
+    return true;
+}
+
+/*
+load_data() behind the parse cache: a warm run copies the decoded board out of the cache entry
+*/
+bool load_board(const char* file_name, int32_t trees_heights[BOARD_SIZE][BOARD_SIZE])
+{
+    const size_t board_bytes = sizeof(int32_t) * BOARD_SIZE * BOARD_SIZE;
+    PERF_BEGIN(lookup, "cache lookup");
+    parse_cache_key_t key;
+    bool has_key = parse_cache_key_file(file_name, &key);
+    parse_cache_entry_t entry = PARSE_CACHE_ENTRY_INITIALIZER;
+    bool is_hit = has_key && parse_cache_load(file_name, "task_8", BOARD_CACHE_FORMAT, &key, &entry)
+                  && entry.payload_size == board_bytes;
+    if(is_hit)
+    {
+        memcpy(trees_heights, entry.payload, board_bytes);
+    }
+    parse_cache_close(&entry);
+    PERF_END(lookup);
+    if(is_hit)
+    {
+        return true;
+    }
+
+    if(!load_data(file_name, trees_heights))
+    {
+        return false;
+    }
+    if(has_key)
+    {
+        parse_cache_store(file_name, "task_8", BOARD_CACHE_FORMAT, &key, trees_heights, board_bytes);
+    }
     return true;
 }
 
@@ -157,15 +212,13 @@ int32_t count_visible_trees(bool hist[BOARD_SIZE][BOARD_SIZE])
     return count;
 }
 
-void part_a(int32_t trees_heights[BOARD_SIZE][BOARD_SIZE], bool is_tree_visible[BOARD_SIZE][BOARD_SIZE])
+int32_t part_a(int32_t trees_heights[BOARD_SIZE][BOARD_SIZE], bool is_tree_visible[BOARD_SIZE][BOARD_SIZE])
 {
-    printf("part a:\n");
     update_hist_horizontal(trees_heights, is_tree_visible, true);
     update_hist_horizontal(trees_heights, is_tree_visible, false);
     update_hist_vertical(trees_heights, is_tree_visible, true);
     update_hist_vertical(trees_heights, is_tree_visible, false);
-    int32_t visible_trees = count_visible_trees(is_tree_visible);
-    printf("Visible trees: %u\n", visible_trees);
+    return count_visible_trees(is_tree_visible);
 }
 
 void update_tree_visible_trees_horizontal(int32_t trees_heights[BOARD_SIZE][BOARD_SIZE], int32_t trees_scores[BOARD_SIZE][BOARD_SIZE], bool is_left_to_right)
@@ -234,23 +287,17 @@ int32_t find_max_score_tree(int32_t trees_scores[BOARD_SIZE][BOARD_SIZE])
 }
 
 
-void part_b(int32_t trees_heights[BOARD_SIZE][BOARD_SIZE], int32_t trees_scores[BOARD_SIZE][BOARD_SIZE])
+int32_t part_b(int32_t trees_heights[BOARD_SIZE][BOARD_SIZE], int32_t trees_scores[BOARD_SIZE][BOARD_SIZE])
 {
-    printf("part b:\n");
     update_tree_visible_trees_horizontal(trees_heights, trees_scores, true);
     update_tree_visible_trees_horizontal(trees_heights, trees_scores, false);
     update_tree_visible_trees_vertical(trees_heights, trees_scores, true);
     update_tree_visible_trees_vertical(trees_heights, trees_scores, false);
-    int32_t max_score = find_max_score_tree(trees_scores);
-    printf("Max score: %u\n", max_score);
+    return find_max_score_tree(trees_scores);
 }
 
-int main()
+void init_scores(int32_t trees_scores[BOARD_SIZE][BOARD_SIZE])
 {
-    bool is_tree_visible[BOARD_SIZE][BOARD_SIZE] = {0};
-    int32_t trees_heights[BOARD_SIZE][BOARD_SIZE] = {0};
-    int32_t trees_scores[BOARD_SIZE][BOARD_SIZE];
-
     for(int32_t i = 0; i<BOARD_SIZE;i++)
     {
         for(int32_t j = 0; j<BOARD_SIZE;j++)
@@ -258,10 +305,75 @@ int main()
             trees_scores[i][j] = 1; // multiplicative identity
         }
     }
+}
+
+typedef struct
+{
+    int32_t trees_heights[BOARD_SIZE][BOARD_SIZE];
+} board_t;
+
+static void* solver_parse(const char* input_path)
+{
+    board_t* board = (board_t*)calloc(1, sizeof(board_t));
+    if(board && !load_board(input_path, board->trees_heights))
+    {
+        free(board);
+        return NULL;
+    }
+    return board;
+}
+
+static bool solver_part1(void* state, char* answer, size_t answer_size)
+{
+    bool is_tree_visible[BOARD_SIZE][BOARD_SIZE] = {0};
+    return solver_answer_u64(answer, answer_size, part_a(((board_t*)state)->trees_heights, is_tree_visible));
+}
+
+static bool solver_part2(void* state, char* answer, size_t answer_size)
+{
+    int32_t trees_scores[BOARD_SIZE][BOARD_SIZE];
+    init_scores(trees_scores);
+    return solver_answer_u64(answer, answer_size, part_b(((board_t*)state)->trees_heights, trees_scores));
+}
+
+static void solver_release(void* state)
+{
+    free(state);
+}
+
+const solver_t task_8_solver = {"task_8", solver_parse, solver_part1, solver_part2, solver_release};
+
+#ifndef AOC_RUNNER
+int main(int argc, char* argv[])
+{
+    int part = parse_part_arg(argc, argv);
+    if(part == PART_INVALID)
+        return 1;
+
+    bool is_tree_visible[BOARD_SIZE][BOARD_SIZE] = {0};
+    int32_t trees_heights[BOARD_SIZE][BOARD_SIZE] = {0};
+    int32_t trees_scores[BOARD_SIZE][BOARD_SIZE];
+    init_scores(trees_scores);
 
     char* file_name = "input.txt";
-    load_data(file_name, trees_heights);
-    part_a(trees_heights, is_tree_visible);
-    part_b(trees_heights, trees_scores);
+    load_board(file_name, trees_heights);
+    if(should_run_part(part, 1))
+    {
+        PERF_BEGIN(part1, "part 1: solve");
+        int32_t visible_trees = part_a(trees_heights, is_tree_visible);
+        PERF_END(part1);
+        printf("part a:\n");
+        printf("Visible trees: %u\n", visible_trees);
+    }
+    if(should_run_part(part, 2))
+    {
+        PERF_BEGIN(part2, "part 2: solve");
+        int32_t max_score = part_b(trees_heights, trees_scores);
+        PERF_END(part2);
+        printf("part b:\n");
+        printf("Max score: %u\n", max_score);
+    }
+    PERF_REPORT();
     return 0;
 }
+#endif
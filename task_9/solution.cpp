@@ -1,11 +1,20 @@
 #include <iostream>
-#include <fstream>
 #include <set>
 #include <deque>
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <cmath>
 #include <vector>
+#include <memory_resource>
+
+#include "../utils/stream_reader.h"
+#include "../utils/parse_int.h"
+#include "../utils/alloc_stats.h"
+#include "../utils/arena.h"
+#include "../utils/part_arg.h"
+#include "../utils/perf_regions.h"
+#include "../utils/solver.h"
 
 /*
 part 1: the rope has only 2 links - head and tail
@@ -68,11 +77,11 @@ class rope_game
 {
 private:
     vector<position_t> knots_positions;
-    set<position_t> tail_positions;
+    pmr::set<position_t> tail_positions; // never shrinks, a good fit for an arena
     void move_head(direction_t direction);
     void move_tail();
 public:
-    rope_game(uint32_t num_knots);
+    rope_game(uint32_t num_knots, pmr::memory_resource* resource = pmr::get_default_resource());
     ~rope_game() = default;
     void play(const play_t& play);
     int32_t get_num_tail_positions();
@@ -108,7 +117,7 @@ class invalid_game_state : public rope_error
 };
 
 
-rope_game::rope_game(uint32_t num_knots) : tail_positions()
+rope_game::rope_game(uint32_t num_knots, pmr::memory_resource* resource) : tail_positions(resource)
 {
     if (num_knots < 2)
         throw invalid_num_knots();
@@ -205,7 +214,7 @@ void rope_game::play(const play_t& play)
 @ format should be: <direction> <steps>
 @ throws an exception if the line is invalid
 */
-play_t parse_line(const string& line)
+play_t parse_line(string_view line)
 {
     /*
     line should be in the format:
@@ -231,50 +240,90 @@ play_t parse_line(const string& line)
         default:
             throw invalid_direction(line[0]);
     }
-    steps = stoi(line.substr(2)); // skip the direction and the space
+    steps = parse_number<int32_t>(line.substr(2)); // skip the direction and the space
     play_t result;
     result.direction = direction;
     result.steps = steps;
     return result;
 }
 
-void part_a()
+int32_t count_tail_positions(string path, uint32_t num_knots, const char* arena_name)
 {
-    rope_game game(2);
-    ifstream input_file("input.txt");
-    string line;
-    while(getline(input_file, line))
+    PERF_SCOPE(num_knots == 2 ? "part 1: read+parse+solve" : "part 2: read+parse+solve"); // the moves are streamed and played one by one
+    ALLOC_STATS_BEGIN(play);
+    ArenaResource arena;
+    int32_t num_tail_positions;
     {
-        play_t play = parse_line(line);
-        game.play(play);
+        rope_game game(num_knots, arena_is_enabled() ? static_cast<pmr::memory_resource*>(&arena) : pmr::new_delete_resource());
+        StreamReader input_file(path);
+        string_view line;
+        while(input_file.next_line(line))
+        {
+            play_t play = parse_line(line);
+            game.play(play);
+        }
+        num_tail_positions = game.get_num_tail_positions();
     }
-    cout << "part a: number of tail positions: " << game.get_num_tail_positions() << endl;
+    ALLOC_STATS_END(play, arena_name); // heap allocations, AOC_NO_ARENA=1 gives the count without the arena
+#ifdef ARENA_STATS
+    arena.print_stats(arena_name);
+#else
+    (void)arena_name;
+#endif
+    return num_tail_positions;
+}
+
+void part_a()
+{
+    cout << "part a: number of tail positions: " << count_tail_positions("input.txt", 2, "task_9 part a") << endl;
 }
 
 void part_b()
 {
-    rope_game game(10);
-    ifstream input_file("input.txt");
-    string line;
-    while(getline(input_file, line))
-    {
-        play_t play = parse_line(line);
-        game.play(play);
-    }
-    cout << "part b: number of tail positions: " << game.get_num_tail_positions() << endl;
+    cout << "part b: number of tail positions: " << count_tail_positions("input.txt", 10, "task_9 part b") << endl;
+}
+
+// the moves are streamed by each part, the state is only the path
+static void* solver_parse(const char* input_path)
+{
+    return new string(input_path);
+}
+
+static bool solver_part1(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, count_tail_positions(*static_cast<string*>(state), 2, "task_9 part a"));
+}
+
+static bool solver_part2(void* state, char* answer, size_t answer_size)
+{
+    return solver_answer_u64(answer, answer_size, count_tail_positions(*static_cast<string*>(state), 10, "task_9 part b"));
+}
+
+static void solver_release(void* state)
+{
+    delete static_cast<string*>(state);
 }
 
+extern "C" const solver_t task_9_solver = {"task_9", solver_parse, solver_part1, solver_part2, solver_release};
 
-int main()
+#ifndef AOC_RUNNER
+int main(int argc, char* argv[])
 {
+    int part = parse_part_arg(argc, argv);
+    if(part == PART_INVALID)
+        return 1;
     try
     {
-        part_a();
-        part_b();
+        if(should_run_part(part, 1))
+            part_a();
+        if(should_run_part(part, 2))
+            part_b();
     }
     catch(const exception& e)
     {
         cerr << e.what() << endl;
     }
+    PERF_REPORT();
     return 0;
 }
+#endif
@@ -0,0 +1,99 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+/*
+heap allocation counter for the C++ days.
+
+building with -DALLOC_STATS replaces the global operator new / delete of the binary with
+versions that count the calls and the bytes asked for, and the macros below print what a
+phase allocated to stderr:
+
+    ALLOC_STATS_BEGIN(solve);
+    ...
+    ALLOC_STATS_END(solve, "part 1");   // part 1: 3 allocations, 96 bytes
+
+without ALLOC_STATS the macros compile to nothing.
+the replacement operators are defined in the header, so only one translation unit of a program
+may be built with ALLOC_STATS (a day binary, not the runner).
+*/
+
+#ifdef ALLOC_STATS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+typedef struct
+{
+    uint64_t allocations;
+    uint64_t bytes;
+} alloc_stats_s;
+
+inline std::atomic<uint64_t> g_alloc_stats_allocations{0};
+inline std::atomic<uint64_t> g_alloc_stats_bytes{0};
+
+inline alloc_stats_s alloc_stats_now()
+{
+    return {g_alloc_stats_allocations.load(std::memory_order_relaxed), g_alloc_stats_bytes.load(std::memory_order_relaxed)};
+}
+
+inline void* alloc_stats_allocate(size_t size)
+{
+    g_alloc_stats_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_stats_bytes.fetch_add(size, std::memory_order_relaxed);
+    void* ptr = malloc(size ? size : 1);
+    if(!ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+// std::pmr::new_delete_resource() goes through the aligned versions
+inline void* alloc_stats_allocate_aligned(size_t size, std::align_val_t alignment)
+{
+    size_t align = static_cast<size_t>(alignment);
+    g_alloc_stats_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_stats_bytes.fetch_add(size, std::memory_order_relaxed);
+    void* ptr = aligned_alloc(align, (size + align - 1) / align * align); // the size must be a multiple of the alignment
+    if(!ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(size_t size) { return alloc_stats_allocate(size); }
+void* operator new[](size_t size) { return alloc_stats_allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return alloc_stats_allocate_aligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return alloc_stats_allocate_aligned(size, alignment); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+
+inline void alloc_stats_print(const char* label, const alloc_stats_s& start)
+{
+    alloc_stats_s now = alloc_stats_now();
+    fprintf(stderr, "%s: %llu allocations, %llu bytes\n", label,
+            (unsigned long long)(now.allocations - start.allocations), (unsigned long long)(now.bytes - start.bytes));
+}
+
+#define ALLOC_STATS_BEGIN(var) alloc_stats_s alloc_stats_##var = alloc_stats_now()
+#define ALLOC_STATS_END(var, label) alloc_stats_print(label, alloc_stats_##var)
+
+#else
+
+#define ALLOC_STATS_BEGIN(var) do {} while(0)
+#define ALLOC_STATS_END(var, label) do {} while(0)
+
+#endif // ALLOC_STATS
+
+#endif
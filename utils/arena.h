@@ -0,0 +1,194 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+bump (arena) allocator, usable from both the C and the C++ days.
+
+allocations are carved out of big chunks by bumping a pointer, nothing is freed on its
+own, and everything is released in one shot by arena_release() at the end of the run.
+every new chunk is twice as big as the previous one (up to ARENA_MAX_CHUNK_SIZE), so
+parsing N lines costs O(log N) calls to malloc instead of O(N).
+
+C++ code gets the same arena as a std::pmr::memory_resource (ArenaResource below),
+so standard containers can draw from it.
+
+building with -DARENA_STATS makes the days print the arena statistics at the end of the run:
+the number of allocations served next to the number of chunks actually taken from malloc.
+setting AOC_NO_ARENA in the environment makes the pmr users (task_9) allocate from the heap instead,
+so a -DALLOC_STATS build shows the heap allocations of the same run with and without the arena.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+#define ARENA_MAX_CHUNK_SIZE (64 * 1024 * 1024)
+
+typedef struct arena_chunk
+{
+    struct arena_chunk* next;
+    size_t size; // usable bytes after the header
+    size_t used;
+} arena_chunk_t;
+
+typedef struct
+{
+    uint64_t allocations;    // calls to arena_alloc()
+    uint64_t bytes_used;     // bytes handed out, including alignment padding
+    uint64_t chunks;         // calls to malloc()
+    uint64_t bytes_reserved; // bytes taken from malloc()
+} arena_stats_t;
+
+typedef struct
+{
+    arena_chunk_t* head; // the chunk allocations are currently served from
+    size_t next_chunk_size;
+    arena_stats_t stats;
+} arena_t;
+
+static inline bool arena_is_enabled(void)
+{
+    return getenv("AOC_NO_ARENA") == NULL;
+}
+
+static inline void arena_init(arena_t* arena, size_t first_chunk_size)
+{
+    arena->head = NULL;
+    arena->next_chunk_size = first_chunk_size ? first_chunk_size : ARENA_DEFAULT_CHUNK_SIZE;
+    memset(&arena->stats, 0, sizeof(arena->stats));
+}
+
+static inline bool arena_add_chunk(arena_t* arena, size_t min_size)
+{
+    size_t size = arena->next_chunk_size;
+    while(size < min_size)
+    {
+        size *= 2;
+    }
+    arena_chunk_t* chunk = (arena_chunk_t*)malloc(sizeof(arena_chunk_t) + size);
+    if(!chunk)
+    {
+        return false;
+    }
+    chunk->next = arena->head;
+    chunk->size = size;
+    chunk->used = 0;
+    arena->head = chunk;
+    if(arena->next_chunk_size < ARENA_MAX_CHUNK_SIZE)
+    {
+        arena->next_chunk_size *= 2;
+    }
+    arena->stats.chunks++;
+    arena->stats.bytes_reserved += sizeof(arena_chunk_t) + size;
+    return true;
+}
+
+/*
+returns NULL if malloc failed, alignment must be a power of 2
+*/
+static inline void* arena_alloc(arena_t* arena, size_t size, size_t alignment)
+{
+    arena_chunk_t* chunk = arena->head;
+    size_t padding = 0;
+    if(chunk)
+    {
+        uintptr_t top = (uintptr_t)(chunk + 1) + chunk->used;
+        padding = (alignment - (top & (alignment - 1))) & (alignment - 1);
+    }
+    if(!chunk || chunk->used + padding + size > chunk->size)
+    {
+        if(!arena_add_chunk(arena, size + alignment))
+        {
+            return NULL;
+        }
+        chunk = arena->head;
+        uintptr_t top = (uintptr_t)(chunk + 1);
+        padding = (alignment - (top & (alignment - 1))) & (alignment - 1);
+    }
+    void* result = (char*)(chunk + 1) + chunk->used + padding;
+    chunk->used += padding + size;
+    arena->stats.allocations++;
+    arena->stats.bytes_used += padding + size;
+    return result;
+}
+
+static inline void* arena_calloc(arena_t* arena, size_t count, size_t size)
+{
+    void* result = arena_alloc(arena, count * size, sizeof(void*));
+    if(result)
+    {
+        memset(result, 0, count * size);
+    }
+    return result;
+}
+
+/*
+free every chunk, the arena can be reused afterwards
+*/
+static inline void arena_release(arena_t* arena)
+{
+    arena_chunk_t* chunk = arena->head;
+    while(chunk)
+    {
+        arena_chunk_t* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+}
+
+static inline void arena_print_stats(const arena_t* arena, const char* name, FILE* stream)
+{
+    fprintf(stream, "arena %s: %llu allocations served from %llu chunks (%llu of %llu bytes used)\n",
+            name,
+            (unsigned long long)arena->stats.allocations,
+            (unsigned long long)arena->stats.chunks,
+            (unsigned long long)arena->stats.bytes_used,
+            (unsigned long long)arena->stats.bytes_reserved);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <memory_resource>
+#include <new>
+
+/*
+std::pmr adapter, deallocate is a no-op and the memory goes away with the resource
+*/
+class ArenaResource : public std::pmr::memory_resource
+{
+private:
+    arena_t m_arena;
+public:
+    explicit ArenaResource(size_t first_chunk_size = ARENA_DEFAULT_CHUNK_SIZE) { arena_init(&m_arena, first_chunk_size); }
+    ~ArenaResource() { arena_release(&m_arena); }
+    ArenaResource(const ArenaResource&) = delete;
+    ArenaResource& operator=(const ArenaResource&) = delete;
+
+    const arena_stats_t& stats() const { return m_arena.stats; }
+    void print_stats(const char* name, FILE* stream = stderr) const { arena_print_stats(&m_arena, name, stream); }
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* result = arena_alloc(&m_arena, bytes, alignment);
+        if(!result)
+        {
+            throw std::bad_alloc();
+        }
+        return result;
+    }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef LINE_RANGES_H
+#define LINE_RANGES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string_view>
+#include <vector>
+
+#include "scanner.h"
+#include "thread_pool.h"
+
+/*
+cutting a buffer into ranges of whole lines for the parallel modes, one range per worker.
+
+split_on_lines() cuts it into num_ranges ranges of about the same size, every range but the
+last one ends right after a newline.
+split_on_line_groups() also moves every cut to a multiple of group_size lines (a group of
+lines is never split between two workers), the lines are counted in parallel on pool first.
+count_line_ranges() is how many ranges the parallel modes cut their input into.
+*/
+
+#define LINE_RANGE_MIN_SIZE (1 << 16) // below that a worker costs more than it saves
+
+typedef struct
+{
+    std::string_view data;
+    uint64_t first_line; // index of the first line of the range in the whole buffer
+} line_range_s;
+
+// one range per worker of pool, but none smaller than LINE_RANGE_MIN_SIZE (and at least one)
+inline size_t count_line_ranges(size_t bytes, const ThreadPool& pool)
+{
+    return std::max<size_t>(1, std::min(pool.size(), bytes / LINE_RANGE_MIN_SIZE));
+}
+
+inline std::vector<std::string_view> split_on_lines(std::string_view data, size_t num_ranges)
+{
+    std::vector<std::string_view> ranges;
+    size_t begin = 0;
+    for(size_t i = 1; i <= num_ranges && begin < data.size(); i++)
+    {
+        size_t end = std::max(begin, data.size() / num_ranges * i);
+        if(i == num_ranges)
+            end = data.size();
+        else if(end < data.size())
+            end = std::min(data.size(), end + scan_find_char(data.data() + end, data.size() - end, '\n') + 1);
+        ranges.push_back(data.substr(begin, end - begin));
+        begin = end;
+    }
+    return ranges;
+}
+
+// offset of the start of the line count lines after the one that starts at pos (or data.size())
+inline size_t skip_lines(std::string_view data, size_t pos, uint64_t count)
+{
+    for(; count && pos < data.size(); count--)
+        pos += scan_find_char(data.data() + pos, data.size() - pos, '\n') + 1;
+    return std::min(pos, data.size());
+}
+
+inline std::vector<line_range_s> split_on_line_groups(std::string_view data, size_t num_ranges, size_t group_size, ThreadPool& pool)
+{
+    std::vector<std::string_view> ranges = split_on_lines(data, num_ranges);
+    std::vector<std::future<uint64_t>> line_counts;
+    for(std::string_view range : ranges)
+        line_counts.push_back(pool.submit([range] { return static_cast<uint64_t>(std::count(range.begin(), range.end(), '\n')); }));
+
+    std::vector<line_range_s> groups;
+    size_t begin = 0;
+    uint64_t first_line = 0;
+    uint64_t line = 0; // lines up to the end of ranges[i], so the index of the first line after it
+    for(size_t i = 0; i < ranges.size(); i++)
+    {
+        line += line_counts[i].get();
+        if(i + 1 == ranges.size())
+            break;
+        // the cut moves forward to the next line index that is a multiple of group_size
+        uint64_t shift = (group_size - line % group_size) % group_size;
+        size_t cut = ranges[i].data() + ranges[i].size() - data.data();
+        size_t end = std::max(begin, skip_lines(data, cut, shift));
+        if(end == begin)
+            continue;
+        groups.push_back({data.substr(begin, end - begin), first_line});
+        begin = end;
+        first_line = line + shift;
+    }
+    if(begin < data.size())
+        groups.push_back({data.substr(begin), first_line});
+    return groups;
+}
+
+#endif
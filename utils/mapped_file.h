@@ -0,0 +1,198 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "scanner.h"
+
+/*
+read only, memory mapped view of a whole input file.
+
+the lines are handed out as std::string_view slices of the mapping, so reading a file
+costs a single mmap instead of a std::string allocation (and a copy) per line.
+the pages are backed by the page cache, so the peak RSS stays close to the file size.
+
+line semantics match std::getline:
+- lines are split on '\n', the newline is not part of the line
+- a trailing newline at the end of the file does not produce an extra empty line
+- '\r' is kept, callers that care should trim it
+*/
+
+struct MappedFileError : public std::runtime_error
+{
+    MappedFileError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+class MappedFile
+{
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    // start offset of every line, built on the first call that needs random access
+    mutable std::vector<size_t> m_line_offsets;
+    mutable bool m_is_indexed = false;
+
+    void build_line_offsets() const;
+public:
+    class LineIterator
+    {
+    private:
+        const char* m_pos;
+        const char* m_end;
+        const char* m_line_end;
+    public:
+        LineIterator(const char* pos, const char* end) : m_pos(pos), m_end(end) { find_line_end(); }
+        void find_line_end()
+        {
+            m_line_end = m_pos + scan_find_char(m_pos, m_end - m_pos, '\n');
+        }
+        std::string_view operator*() const { return std::string_view(m_pos, m_line_end - m_pos); }
+        LineIterator& operator++()
+        {
+            m_pos = (m_line_end < m_end) ? m_line_end + 1 : m_end;
+            find_line_end();
+            return *this;
+        }
+        bool operator!=(const LineIterator& other) const { return m_pos != other.m_pos; }
+        bool operator==(const LineIterator& other) const { return m_pos == other.m_pos; }
+    };
+
+    class LineRange
+    {
+    private:
+        const char* m_begin;
+        const char* m_end;
+    public:
+        LineRange(const char* begin, const char* end) : m_begin(begin), m_end(end) {}
+        LineIterator begin() const { return LineIterator(m_begin, m_end); }
+        LineIterator end() const { return LineIterator(m_end, m_end); }
+    };
+
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+
+    void prefault() const;
+
+    std::string_view data() const { return std::string_view(m_data, m_size); }
+    size_t size() const { return m_size; }
+
+    // sequential access, does not build the line index
+    LineRange lines() const { return LineRange(m_data, m_data + m_size); }
+
+    // random access, builds the line index on first use
+    const std::vector<size_t>& line_offsets() const;
+    size_t line_count() const { return line_offsets().size(); }
+    std::string_view line(size_t index) const;
+};
+
+inline MappedFile::MappedFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        throw MappedFileError("failed to open " + path);
+    }
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0)
+    {
+        close(fd);
+        throw MappedFileError("failed to stat " + path);
+    }
+    m_size = static_cast<size_t>(file_stat.st_size);
+    if(m_size > 0) // mmap of an empty file fails, leave m_data as nullptr
+    {
+        void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED)
+        {
+            close(fd);
+            throw MappedFileError("failed to mmap " + path);
+        }
+        madvise(mapping, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(mapping);
+    }
+    close(fd); // the mapping keeps its own reference to the file
+}
+
+inline MappedFile::~MappedFile()
+{
+    if(m_data)
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+}
+
+inline MappedFile::MappedFile(MappedFile&& other) noexcept :
+    m_data(other.m_data), m_size(other.m_size), m_line_offsets(std::move(other.m_line_offsets)), m_is_indexed(other.m_is_indexed)
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_is_indexed = false;
+}
+
+/*
+faults every page of the mapping in now (one read per page), so a "read" perf region around the
+constructor and this call times the whole file read, not just the mmap
+*/
+inline void MappedFile::prefault() const
+{
+    if(!m_data)
+        return;
+    madvise(const_cast<char*>(m_data), m_size, MADV_WILLNEED);
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t step = page_size > 0 ? static_cast<size_t>(page_size) : 4096;
+    char sum = 0;
+    for(size_t offset = 0; offset < m_size; offset += step)
+        sum ^= static_cast<const volatile char*>(m_data)[offset];
+    (void)sum;
+}
+
+inline void MappedFile::build_line_offsets() const
+{
+    // the lines are counted first, so the index is built in place at its final size (8 bytes per line)
+    m_line_offsets.clear();
+    m_line_offsets.shrink_to_fit();
+    m_line_offsets.reserve(std::count(m_data, m_data + m_size, '\n') + 1);
+    // vectorized newline search (scanner.h), a trailing newline does not start a new line
+    for(size_t pos = 0; pos < m_size; pos += scan_find_char(m_data + pos, m_size - pos, '\n') + 1)
+        m_line_offsets.push_back(pos);
+    m_is_indexed = true;
+}
+
+inline const std::vector<size_t>& MappedFile::line_offsets() const
+{
+    if(!m_is_indexed)
+    {
+        build_line_offsets();
+    }
+    return m_line_offsets;
+}
+
+inline std::string_view MappedFile::line(size_t index) const
+{
+    const std::vector<size_t>& offsets = line_offsets();
+    if(index >= offsets.size())
+    {
+        throw std::out_of_range("MappedFile::line(): index out of range");
+    }
+    size_t begin = offsets[index];
+    size_t end = (index + 1 < offsets.size()) ? offsets[index + 1] - 1 : m_size;
+    if(end == m_size && end > begin && m_data[end - 1] == '\n') // last line ends with a newline
+        end--;
+    return std::string_view(m_data + begin, end - begin);
+}
+
+#endif
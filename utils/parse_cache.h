@@ -0,0 +1,268 @@
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+/*
+content-hash keyed cache of parsed inputs, usable from both the C and the C++ days.
+
+a day that opts in stores its parsed representation (a flat, pointer free payload) in
+<input dir>/.aoc_cache/<day>.bin next to a fixed header:
+- magic and PARSE_CACHE_VERSION (the layout of the header)
+- the day's own format version (bump it whenever the payload layout changes)
+- the hash and size of the input bytes the payload was parsed from
+on the next run the input is hashed (a single pass, much cheaper than parsing text), and if
+every field of the header matches, the payload is mmap-ed and used as is. any mismatch is a
+miss, the day parses the text and overwrites the entry, so invalidation is automatic.
+entries are written to a temporary file and renamed, a reader never sees half an entry.
+
+setting AOC_NO_CACHE in the environment disables both loading and storing.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PARSE_CACHE_VERSION 1
+#define PARSE_CACHE_DIR ".aoc_cache"
+#define PARSE_CACHE_MAGIC "AOCCACHE"
+#define PARSE_CACHE_PATH_SIZE 4096
+
+typedef struct
+{
+    char magic[8];
+    uint32_t cache_version;
+    uint32_t format_version;
+    uint64_t input_hash;
+    uint64_t input_size;
+    uint64_t payload_size;
+    uint8_t reserved[24]; // keeps the payload 64 byte aligned in the mapping
+} parse_cache_header_t;
+
+typedef struct
+{
+    const void* payload;
+    size_t payload_size;
+    void* mapping;
+    size_t mapping_size;
+} parse_cache_entry_t;
+
+#define PARSE_CACHE_ENTRY_INITIALIZER {NULL, 0, NULL, 0}
+
+/*
+identifies an input: the hash and the size of its bytes
+*/
+typedef struct
+{
+    uint64_t hash;
+    uint64_t size;
+} parse_cache_key_t;
+
+static inline bool parse_cache_is_enabled(void)
+{
+    return getenv("AOC_NO_CACHE") == NULL;
+}
+
+static inline uint64_t parse_cache_mix(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+/*
+64 bit hash of the bytes, 4 independent lanes of 8 bytes so the multiplies overlap
+*/
+static inline uint64_t parse_cache_hash(const void* data, size_t size)
+{
+    const uint64_t prime = 0x9e3779b97f4a7c15ULL;
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t lanes[4] = {prime, prime * 3, prime * 5, prime * 7};
+    size_t pos = 0;
+    for(; pos + 32 <= size; pos += 32)
+    {
+        for(int lane = 0; lane < 4; lane++)
+        {
+            uint64_t word;
+            memcpy(&word, bytes + pos + lane * 8, sizeof(word));
+            lanes[lane] = (lanes[lane] ^ word) * prime;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+    uint64_t hash = size;
+    for(int lane = 0; lane < 4; lane++)
+    {
+        hash = (hash ^ parse_cache_mix(lanes[lane])) * prime;
+    }
+    for(; pos < size; pos++)
+    {
+        hash = (hash ^ bytes[pos]) * prime;
+    }
+    return parse_cache_mix(hash);
+}
+
+/*
+hash the file at input_path, returns false if it can not be read
+*/
+static inline bool parse_cache_key_file(const char* input_path, parse_cache_key_t* key)
+{
+    int fd = open(input_path, O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    key->size = (uint64_t)file_stat.st_size;
+    if(key->size == 0)
+    {
+        close(fd);
+        key->hash = parse_cache_hash(NULL, 0);
+        return true;
+    }
+    void* data = mmap(NULL, key->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(data, key->size, MADV_SEQUENTIAL);
+    key->hash = parse_cache_hash(data, key->size);
+    munmap(data, key->size);
+    return true;
+}
+
+/*
+<dir of input_path>/.aoc_cache[/<day>.bin], returns false if the path does not fit
+*/
+static inline bool parse_cache_path(const char* input_path, const char* day, char* path, size_t path_size)
+{
+    const char* slash = strrchr(input_path, '/');
+    int dir_length = slash ? (int)(slash - input_path) : 1;
+    const char* dir = slash ? input_path : ".";
+    int length = day ? snprintf(path, path_size, "%.*s/%s/%s.bin", dir_length, dir, PARSE_CACHE_DIR, day)
+                     : snprintf(path, path_size, "%.*s/%s", dir_length, dir, PARSE_CACHE_DIR);
+    return length > 0 && (size_t)length < path_size;
+}
+
+/*
+map the entry of the day if it was parsed from the same input with the same format,
+returns false on a miss (entry is left empty)
+*/
+static inline bool parse_cache_load(const char* input_path, const char* day, uint32_t format_version,
+                                    const parse_cache_key_t* key, parse_cache_entry_t* entry)
+{
+    char path[PARSE_CACHE_PATH_SIZE];
+    if(!parse_cache_is_enabled() || !parse_cache_path(input_path, day, path, sizeof(path)))
+    {
+        return false;
+    }
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(parse_cache_header_t))
+    {
+        close(fd);
+        return false;
+    }
+    size_t mapping_size = (size_t)file_stat.st_size;
+    void* mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    const parse_cache_header_t* header = (const parse_cache_header_t*)mapping;
+    if(memcmp(header->magic, PARSE_CACHE_MAGIC, sizeof(header->magic)) != 0
+       || header->cache_version != PARSE_CACHE_VERSION
+       || header->format_version != format_version
+       || header->input_hash != key->hash
+       || header->input_size != key->size
+       || header->payload_size != mapping_size - sizeof(parse_cache_header_t))
+    {
+        munmap(mapping, mapping_size);
+        return false;
+    }
+    entry->mapping = mapping;
+    entry->mapping_size = mapping_size;
+    entry->payload = header + 1;
+    entry->payload_size = header->payload_size;
+    return true;
+}
+
+static inline void parse_cache_close(parse_cache_entry_t* entry)
+{
+    if(entry->mapping)
+    {
+        munmap(entry->mapping, entry->mapping_size);
+    }
+    entry->mapping = NULL;
+    entry->payload = NULL;
+}
+
+/*
+write (or replace) the entry of the day, a failure only means the next run parses again
+*/
+static inline bool parse_cache_store(const char* input_path, const char* day, uint32_t format_version,
+                                     const parse_cache_key_t* key, const void* payload, size_t payload_size)
+{
+    char dir[PARSE_CACHE_PATH_SIZE], path[PARSE_CACHE_PATH_SIZE], temp_path[PARSE_CACHE_PATH_SIZE + 64];
+    if(!parse_cache_is_enabled()
+       || !parse_cache_path(input_path, NULL, dir, sizeof(dir))
+       || !parse_cache_path(input_path, day, path, sizeof(path)))
+    {
+        return false;
+    }
+    mkdir(dir, 0755); // may already exist
+    // pid and payload address keep concurrent writers (processes or runner threads) apart
+    snprintf(temp_path, sizeof(temp_path), "%s.%ld.%lx.tmp", path, (long)getpid(), (unsigned long)(uintptr_t)payload);
+
+    parse_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PARSE_CACHE_MAGIC, sizeof(header.magic));
+    header.cache_version = PARSE_CACHE_VERSION;
+    header.format_version = format_version;
+    header.input_hash = key->hash;
+    header.input_size = key->size;
+    header.payload_size = payload_size;
+
+    FILE* file = fopen(temp_path, "wb");
+    if(!file)
+    {
+        return false;
+    }
+    bool is_written = fwrite(&header, sizeof(header), 1, file) == 1
+                      && (payload_size == 0 || fwrite(payload, payload_size, 1, file) == 1);
+    is_written = (fclose(file) == 0) && is_written;
+    if(!is_written || rename(temp_path, path) != 0)
+    {
+        unlink(temp_path);
+        return false;
+    }
+    return true;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
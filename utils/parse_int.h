@@ -0,0 +1,171 @@
+#ifndef PARSE_INT_H
+#define PARSE_INT_H
+
+/*
+allocation free integer parsing, usable from both the C and the C++ days.
+
+the functions follow std::from_chars:
+- they parse the longest run of decimal digits at the start of [first, last)
+- no leading whitespace and no '+' sign, '-' only for the signed versions
+- they return a pointer one past the last consumed character,
+  or NULL if there are no digits or the value does not fit (out is untouched)
+
+when at least 8 bytes are available the first 8 digits are validated and converted
+at once inside a 64-bit register (SWAR), instead of one multiply-add per character.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SWAR_ONES(byte) (0x0101010101010101ULL * (uint64_t)(byte))
+
+/*
+number of leading decimal digits in the 8 bytes of chunk (first character in the lowest byte)
+*/
+static inline uint32_t swar_count_digits(uint64_t chunk)
+{
+    // a byte is a digit if its high nibble is 3 and it stays under 0x3a after adding 6
+    // (a carry out of a non digit byte only affects the bytes after it, which are never counted)
+    uint64_t not_digit = ((chunk & SWAR_ONES(0xF0)) ^ SWAR_ONES(0x30)) |
+                         (((chunk + SWAR_ONES(0x06)) & SWAR_ONES(0xF0)) ^ SWAR_ONES(0x30));
+    // move "byte is not zero" to the high bit of every byte
+    uint64_t high_bits = (((not_digit & SWAR_ONES(0x7F)) + SWAR_ONES(0x7F)) | not_digit) & SWAR_ONES(0x80);
+    return high_bits ? (uint32_t)(__builtin_ctzll(high_bits) / 8) : 8;
+}
+
+/*
+value of the first num_digits (1-8) characters of chunk, all of them must be digits
+*/
+static inline uint64_t swar_digits_value(uint64_t chunk, uint32_t num_digits)
+{
+    uint64_t digits = chunk - SWAR_ONES('0');
+    // right align the number, the bytes shifted in at the bottom act as leading zeros
+    digits <<= 8 * (8 - num_digits);
+    digits = ((digits * 10) + (digits >> 8)) & 0x00FF00FF00FF00FFULL;        // 4 numbers of 2 digits
+    digits = ((digits * 100) + (digits >> 16)) & 0x0000FFFF0000FFFFULL;      // 2 numbers of 4 digits
+    digits = ((digits * 10000) + (digits >> 32)) & 0x00000000FFFFFFFFULL;    // 1 number of 8 digits
+    return digits;
+}
+
+static inline const char* parse_uint64(const char* first, const char* last, uint64_t* out)
+{
+    const char* pos = first;
+    uint64_t value = 0;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    if(last - pos >= 8)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, pos, sizeof(chunk));
+        uint32_t num_digits = swar_count_digits(chunk);
+        if(num_digits == 0)
+        {
+            return NULL;
+        }
+        value = swar_digits_value(chunk, num_digits);
+        pos += num_digits;
+        if(num_digits < 8)
+        {
+            *out = value;
+            return pos;
+        }
+    }
+#endif
+    // short ranges, and whatever comes after the first 8 digits
+    for(; pos < last && (uint8_t)(*pos - '0') < 10; pos++)
+    {
+        if(__builtin_mul_overflow(value, 10, &value) || __builtin_add_overflow(value, (uint64_t)(*pos - '0'), &value))
+        {
+            return NULL;
+        }
+    }
+    if(pos == first)
+    {
+        return NULL;
+    }
+    *out = value;
+    return pos;
+}
+
+static inline const char* parse_uint32(const char* first, const char* last, uint32_t* out)
+{
+    uint64_t value;
+    const char* pos = parse_uint64(first, last, &value);
+    if(!pos || value > UINT32_MAX)
+    {
+        return NULL;
+    }
+    *out = (uint32_t)value;
+    return pos;
+}
+
+static inline const char* parse_int64(const char* first, const char* last, int64_t* out)
+{
+    bool is_negative = (first < last && *first == '-');
+    uint64_t magnitude;
+    const char* pos = parse_uint64(first + (is_negative ? 1 : 0), last, &magnitude);
+    if(!pos)
+    {
+        return NULL;
+    }
+    if(is_negative)
+    {
+        if(magnitude > (uint64_t)INT64_MAX + 1)
+            return NULL;
+        *out = (int64_t)(0 - magnitude);
+    }
+    else
+    {
+        if(magnitude > (uint64_t)INT64_MAX)
+            return NULL;
+        *out = (int64_t)magnitude;
+    }
+    return pos;
+}
+
+static inline const char* parse_int32(const char* first, const char* last, int32_t* out)
+{
+    int64_t value;
+    const char* pos = parse_int64(first, last, &value);
+    if(!pos || value < INT32_MIN || value > INT32_MAX)
+    {
+        return NULL;
+    }
+    *out = (int32_t)value;
+    return pos;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+inline const char* parse_int(std::string_view str, uint64_t& out) { return parse_uint64(str.data(), str.data() + str.size(), &out); }
+inline const char* parse_int(std::string_view str, uint32_t& out) { return parse_uint32(str.data(), str.data() + str.size(), &out); }
+inline const char* parse_int(std::string_view str, int64_t& out) { return parse_int64(str.data(), str.data() + str.size(), &out); }
+inline const char* parse_int(std::string_view str, int32_t& out) { return parse_int32(str.data(), str.data() + str.size(), &out); }
+
+/*
+drop in replacement for stoi and friends, only the error path allocates
+throws std::invalid_argument if str does not start with a number that fits in T
+*/
+template <typename T>
+T parse_number(std::string_view str)
+{
+    T value;
+    if(!parse_int(str, value))
+    {
+        throw std::invalid_argument("parse_number(): invalid number: " + std::string(str));
+    }
+    return value;
+}
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef PART_ARG_H
+#define PART_ARG_H
+
+/*
+command line convention shared by every day: solution [part]
+- no argument runs both parts
+- "1" or "2" runs only that part (used by the benchmark harness to time the parts separately)
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PART_BOTH 0
+#define PART_INVALID -1
+
+static inline int parse_part_arg(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        return PART_BOTH;
+    }
+    if(strcmp(argv[1], "1") == 0)
+    {
+        return 1;
+    }
+    if(strcmp(argv[1], "2") == 0)
+    {
+        return 2;
+    }
+    fprintf(stderr, "usage: %s [1|2]\n", argv[0]);
+    return PART_INVALID;
+}
+
+static inline int should_run_part(int selected_part, int part)
+{
+    return selected_part == PART_BOTH || selected_part == part;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef PERF_REGIONS_H
+#define PERF_REGIONS_H
+
+/*
+per phase hardware counter instrumentation, usable from both the C and the C++ days.
+
+build with -DPERF_REGIONS (make perf) to enable it, otherwise every macro below compiles to nothing.
+
+a region measures the wall time and the linux perf_event_open counters between its begin and end:
+cycles, instructions, branch misses, L1d read misses, LLC misses and page faults.
+regions with the same name are accumulated, and PERF_REPORT() prints one line per name.
+counters that can not be opened (containers, perf_event_paranoid, virtual machines) are
+reported as "-", and the wall time is always there.
+only the calling thread is counted.
+
+C:   PERF_BEGIN(parse, "parse"); ... PERF_END(parse);
+C++: { PERF_SCOPE("parse"); ... }
+*/
+
+#ifdef PERF_REGIONS
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_PAGE_FAULTS,
+    PERF_NUM_COUNTERS
+} perf_counter_e;
+
+#define PERF_MAX_PHASES 32
+
+typedef struct
+{
+    const char* name;
+    uint64_t calls;
+    uint64_t wall_ns;
+    uint64_t counters[PERF_NUM_COUNTERS];
+} perf_phase_t;
+
+typedef struct
+{
+    bool is_initialized;
+    int fds[PERF_NUM_COUNTERS]; // -1 if the counter is not available
+    perf_phase_t phases[PERF_MAX_PHASES];
+    uint32_t num_phases;
+} perf_state_t;
+
+typedef struct
+{
+    const char* name;
+    uint64_t start_ns;
+    uint64_t start_counters[PERF_NUM_COUNTERS];
+} perf_region_t;
+
+static inline perf_state_t* perf_state(void)
+{
+    static perf_state_t state;
+    return &state;
+}
+
+static inline int perf_open_counter(uint32_t type, uint64_t config, bool is_user_only)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = is_user_only ? 1 : 0;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static inline void perf_init(void)
+{
+    perf_state_t* state = perf_state();
+    if(state->is_initialized)
+    {
+        return;
+    }
+    const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    state->fds[PERF_CYCLES] = perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true);
+    state->fds[PERF_INSTRUCTIONS] = perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true);
+    state->fds[PERF_BRANCH_MISSES] = perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, true);
+    state->fds[PERF_L1D_MISSES] = perf_open_counter(PERF_TYPE_HW_CACHE, l1d_read_miss, true);
+    state->fds[PERF_LLC_MISSES] = perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, true);
+    state->fds[PERF_PAGE_FAULTS] = perf_open_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, false);
+    state->is_initialized = true;
+}
+
+static inline uint64_t perf_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static inline void perf_read_counters(uint64_t values[PERF_NUM_COUNTERS])
+{
+    perf_state_t* state = perf_state();
+    for(int i = 0; i < PERF_NUM_COUNTERS; i++)
+    {
+        values[i] = 0;
+        if(state->fds[i] >= 0 && read(state->fds[i], &values[i], sizeof(values[i])) != sizeof(values[i]))
+        {
+            values[i] = 0;
+        }
+    }
+}
+
+static inline void perf_begin(perf_region_t* region, const char* name)
+{
+    perf_init();
+    region->name = name;
+    perf_read_counters(region->start_counters);
+    region->start_ns = perf_now_ns(); // last, so the counter reads are not part of the region
+}
+
+static inline void perf_end(perf_region_t* region)
+{
+    uint64_t end_ns = perf_now_ns();
+    uint64_t end_counters[PERF_NUM_COUNTERS];
+    perf_read_counters(end_counters);
+
+    perf_state_t* state = perf_state();
+    perf_phase_t* phase = NULL;
+    for(uint32_t i = 0; i < state->num_phases; i++)
+    {
+        if(strcmp(state->phases[i].name, region->name) == 0)
+        {
+            phase = &state->phases[i];
+            break;
+        }
+    }
+    if(!phase)
+    {
+        if(state->num_phases == PERF_MAX_PHASES)
+        {
+            return; // out of slots, drop the sample
+        }
+        phase = &state->phases[state->num_phases++];
+        memset(phase, 0, sizeof(*phase));
+        phase->name = region->name;
+    }
+    phase->calls++;
+    phase->wall_ns += end_ns - region->start_ns;
+    for(int i = 0; i < PERF_NUM_COUNTERS; i++)
+    {
+        phase->counters[i] += end_counters[i] - region->start_counters[i];
+    }
+}
+
+static inline void perf_print_counter(FILE* stream, int fd, uint64_t value)
+{
+    if(fd >= 0)
+        fprintf(stream, " %14llu", (unsigned long long)value);
+    else
+        fprintf(stream, " %14s", "-");
+}
+
+static inline void perf_report(FILE* stream)
+{
+    perf_state_t* state = perf_state();
+    if(state->num_phases == 0)
+    {
+        return;
+    }
+    bool has_counters = false;
+    for(int i = 0; i < PERF_NUM_COUNTERS; i++)
+    {
+        has_counters = has_counters || (state->fds[i] >= 0);
+    }
+    if(!has_counters)
+    {
+        fprintf(stream, "perf counters not available, wall clock only\n");
+    }
+    fprintf(stream, "%-24s %6s %10s %14s %14s %6s %14s %14s %14s %14s\n",
+            "phase", "calls", "wall_ms", "cycles", "instructions", "ipc", "branch_misses", "l1d_misses", "llc_misses", "page_faults");
+    for(uint32_t p = 0; p < state->num_phases; p++)
+    {
+        perf_phase_t* phase = &state->phases[p];
+        fprintf(stream, "%-24s %6llu %10.3f", phase->name, (unsigned long long)phase->calls, phase->wall_ns / 1e6);
+        perf_print_counter(stream, state->fds[PERF_CYCLES], phase->counters[PERF_CYCLES]);
+        perf_print_counter(stream, state->fds[PERF_INSTRUCTIONS], phase->counters[PERF_INSTRUCTIONS]);
+        if(state->fds[PERF_CYCLES] >= 0 && state->fds[PERF_INSTRUCTIONS] >= 0 && phase->counters[PERF_CYCLES] > 0)
+            fprintf(stream, " %6.2f", (double)phase->counters[PERF_INSTRUCTIONS] / (double)phase->counters[PERF_CYCLES]);
+        else
+            fprintf(stream, " %6s", "-");
+        perf_print_counter(stream, state->fds[PERF_BRANCH_MISSES], phase->counters[PERF_BRANCH_MISSES]);
+        perf_print_counter(stream, state->fds[PERF_L1D_MISSES], phase->counters[PERF_L1D_MISSES]);
+        perf_print_counter(stream, state->fds[PERF_LLC_MISSES], phase->counters[PERF_LLC_MISSES]);
+        perf_print_counter(stream, state->fds[PERF_PAGE_FAULTS], phase->counters[PERF_PAGE_FAULTS]);
+        fprintf(stream, "\n");
+    }
+}
+
+#ifdef __cplusplus
+} // extern "C"
+
+class ScopedPerfRegion
+{
+private:
+    perf_region_t m_region;
+public:
+    explicit ScopedPerfRegion(const char* name) { perf_begin(&m_region, name); }
+    ~ScopedPerfRegion() { perf_end(&m_region); }
+    ScopedPerfRegion(const ScopedPerfRegion&) = delete;
+    ScopedPerfRegion& operator=(const ScopedPerfRegion&) = delete;
+};
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+#define PERF_SCOPE(name) ScopedPerfRegion PERF_CONCAT(perf_scope_, __LINE__)(name)
+#endif
+
+#define PERF_BEGIN(var, name) perf_region_t perf_region_##var; perf_begin(&perf_region_##var, name)
+#define PERF_END(var) perf_end(&perf_region_##var)
+#define PERF_REPORT() perf_report(stderr)
+
+#else // PERF_REGIONS
+
+#define PERF_BEGIN(var, name)
+#define PERF_END(var)
+#define PERF_REPORT()
+#define PERF_SCOPE(name)
+
+#endif // PERF_REGIONS
+
+#endif
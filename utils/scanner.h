@@ -0,0 +1,331 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+/*
+vectorized byte scanner, usable from both the C and the C++ days.
+
+scan_buffer() walks a whole buffer once and records the offset of every newline
+(and optionally every occurrence of a second delimiter) into growable offset lists.
+scan_find_char() is the single character version, used by the field splitters.
+the C++ days get the index as a ScanIndex, task_4 takes the comma of every line from it.
+
+the kernel is picked on the first call according to cpuid:
+- AVX2 - 32 bytes per compare
+- SSE2 - 16 bytes per compare
+- scalar fallback for other architectures
+the compare results are turned into bitmasks (movemask), and the offsets are
+extracted from the set bits with count-trailing-zeros, so the cost per byte does
+not depend on the line length.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCANNER_X86 1
+#define SCANNER_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    size_t* offsets;
+    size_t count;
+    size_t capacity;
+} offset_list_t;
+
+#define OFFSET_LIST_INITIALIZER {NULL, 0, 0}
+
+static inline void offset_list_free(offset_list_t* list)
+{
+    if(list->offsets)
+    {
+        free(list->offsets);
+    }
+    list->offsets = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/*
+make room for at least "extra" more offsets
+returns false if the allocation failed (the list is left untouched)
+*/
+static inline bool offset_list_reserve(offset_list_t* list, size_t extra)
+{
+    if(list->count + extra <= list->capacity)
+    {
+        return true;
+    }
+    size_t new_capacity = list->capacity ? list->capacity : 64;
+    while(new_capacity < list->count + extra)
+    {
+        new_capacity *= 2;
+    }
+    size_t* new_offsets = (size_t*)realloc(list->offsets, new_capacity * sizeof(size_t));
+    if(!new_offsets)
+    {
+        return false;
+    }
+    list->offsets = new_offsets;
+    list->capacity = new_capacity;
+    return true;
+}
+
+/*
+append base + index of every set bit in mask, in increasing order
+*/
+static inline bool scan_emit_mask(offset_list_t* list, size_t base, uint32_t mask)
+{
+    if(!mask)
+    {
+        return true;
+    }
+    if(!offset_list_reserve(list, (size_t)__builtin_popcount(mask)))
+    {
+        return false;
+    }
+    while(mask)
+    {
+        list->offsets[list->count++] = base + (size_t)__builtin_ctz(mask);
+        mask &= mask - 1; // clear the lowest set bit
+    }
+    return true;
+}
+
+static inline bool scan_buffer_scalar(const char* buf, size_t len, size_t base, char delim, offset_list_t* newlines, offset_list_t* delims)
+{
+    for(size_t i = 0; i < len; i++)
+    {
+        if(buf[i] == '\n')
+        {
+            if(!offset_list_reserve(newlines, 1))
+                return false;
+            newlines->offsets[newlines->count++] = base + i;
+        }
+        else if(delims && buf[i] == delim)
+        {
+            if(!offset_list_reserve(delims, 1))
+                return false;
+            delims->offsets[delims->count++] = base + i;
+        }
+    }
+    return true;
+}
+
+static inline size_t scan_find_char_scalar(const char* buf, size_t len, char c)
+{
+    for(size_t i = 0; i < len; i++)
+    {
+        if(buf[i] == c)
+            return i;
+    }
+    return len;
+}
+
+#ifdef SCANNER_X86
+
+SCANNER_TARGET("sse2")
+static inline bool scan_buffer_sse2(const char* buf, size_t len, size_t base, char delim, offset_list_t* newlines, offset_list_t* delims)
+{
+    const __m128i newline_vec = _mm_set1_epi8('\n');
+    const __m128i delim_vec = _mm_set1_epi8(delim);
+    size_t i = 0;
+    for(; i + 16 <= len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(buf + i));
+        uint32_t newline_mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline_vec));
+        if(!scan_emit_mask(newlines, base + i, newline_mask))
+            return false;
+        if(delims)
+        {
+            uint32_t delim_mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, delim_vec));
+            if(!scan_emit_mask(delims, base + i, delim_mask))
+                return false;
+        }
+    }
+    return scan_buffer_scalar(buf + i, len - i, base + i, delim, newlines, delims);
+}
+
+SCANNER_TARGET("avx2")
+static inline bool scan_buffer_avx2(const char* buf, size_t len, size_t base, char delim, offset_list_t* newlines, offset_list_t* delims)
+{
+    const __m256i newline_vec = _mm256_set1_epi8('\n');
+    const __m256i delim_vec = _mm256_set1_epi8(delim);
+    size_t i = 0;
+    for(; i + 32 <= len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(buf + i));
+        uint32_t newline_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline_vec));
+        if(!scan_emit_mask(newlines, base + i, newline_mask))
+            return false;
+        if(delims)
+        {
+            uint32_t delim_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, delim_vec));
+            if(!scan_emit_mask(delims, base + i, delim_mask))
+                return false;
+        }
+    }
+    return scan_buffer_sse2(buf + i, len - i, base + i, delim, newlines, delims);
+}
+
+SCANNER_TARGET("sse2")
+static inline size_t scan_find_char_sse2(const char* buf, size_t len, char c)
+{
+    const __m128i char_vec = _mm_set1_epi8(c);
+    size_t i = 0;
+    for(; i + 16 <= len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(buf + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, char_vec));
+        if(mask)
+            return i + (size_t)__builtin_ctz(mask);
+    }
+    return i + scan_find_char_scalar(buf + i, len - i, c);
+}
+
+SCANNER_TARGET("avx2")
+static inline size_t scan_find_char_avx2(const char* buf, size_t len, char c)
+{
+    const __m256i char_vec = _mm256_set1_epi8(c);
+    size_t i = 0;
+    for(; i + 32 <= len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(buf + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, char_vec));
+        if(mask)
+            return i + (size_t)__builtin_ctz(mask);
+    }
+    return i + scan_find_char_sse2(buf + i, len - i, c);
+}
+
+#endif // SCANNER_X86
+
+typedef enum
+{
+    SCAN_ISA_SCALAR = 0,
+    SCAN_ISA_SSE2,
+    SCAN_ISA_AVX2
+} scan_isa_e;
+
+/*
+cpuid based kernel selection, evaluated once
+*/
+static inline scan_isa_e scan_detect_isa(void)
+{
+    // the days may scan from several threads (runner, parallel modes), the cached value is published atomically
+    static int cached = -1;
+    int detected = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+    if(detected < 0)
+    {
+        detected = SCAN_ISA_SCALAR;
+#ifdef SCANNER_X86
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2"))
+            detected = SCAN_ISA_AVX2;
+        else if(__builtin_cpu_supports("sse2"))
+            detected = SCAN_ISA_SSE2;
+#endif
+        __atomic_store_n(&cached, detected, __ATOMIC_RELAXED);
+    }
+    return (scan_isa_e)detected;
+}
+
+/*
+record the offset of every '\n' in buf into newlines,
+and (if delims is not NULL) the offset of every delim into delims.
+offsets are relative to buf and are appended to whatever the lists already hold.
+returns false if an allocation failed
+*/
+static inline bool scan_buffer(const char* buf, size_t len, char delim, offset_list_t* newlines, offset_list_t* delims)
+{
+    switch(scan_detect_isa())
+    {
+#ifdef SCANNER_X86
+        case SCAN_ISA_AVX2:
+            return scan_buffer_avx2(buf, len, 0, delim, newlines, delims);
+        case SCAN_ISA_SSE2:
+            return scan_buffer_sse2(buf, len, 0, delim, newlines, delims);
+#endif
+        default:
+            return scan_buffer_scalar(buf, len, 0, delim, newlines, delims);
+    }
+}
+
+/*
+index of the first c in buf, or len if there is none
+*/
+static inline size_t scan_find_char(const char* buf, size_t len, char c)
+{
+    switch(scan_detect_isa())
+    {
+#ifdef SCANNER_X86
+        case SCAN_ISA_AVX2:
+            return scan_find_char_avx2(buf, len, c);
+        case SCAN_ISA_SSE2:
+            return scan_find_char_sse2(buf, len, c);
+#endif
+        default:
+            return scan_find_char_scalar(buf, len, c);
+    }
+}
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <new>
+#include <string_view>
+#include <vector>
+
+/*
+owner of the one-pass index of a buffer (scan_buffer): the offset of every newline and of every delim,
+throws std::bad_alloc if the lists can not grow
+*/
+struct ScanIndex
+{
+    offset_list_t newlines = OFFSET_LIST_INITIALIZER;
+    offset_list_t delims = OFFSET_LIST_INITIALIZER;
+
+    ScanIndex(std::string_view data, char delim)
+    {
+        if(!scan_buffer(data.data(), data.size(), delim, &newlines, &delims))
+        {
+            offset_list_free(&newlines);
+            offset_list_free(&delims);
+            throw std::bad_alloc();
+        }
+    }
+    ~ScanIndex()
+    {
+        offset_list_free(&newlines);
+        offset_list_free(&delims);
+    }
+    ScanIndex(const ScanIndex&) = delete;
+    ScanIndex& operator=(const ScanIndex&) = delete;
+};
+
+/*
+split line on every sep, empty fields are kept
+*/
+inline void split_fields(std::string_view line, char sep, std::vector<std::string_view>& fields)
+{
+    fields.clear();
+    size_t begin = 0;
+    while(true)
+    {
+        size_t sep_index = begin + scan_find_char(line.data() + begin, line.length() - begin, sep);
+        fields.push_back(line.substr(begin, sep_index - begin));
+        if(sep_index >= line.length())
+            break;
+        begin = sep_index + 1;
+    }
+}
+#endif
+
+#endif
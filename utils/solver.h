@@ -0,0 +1,53 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+/*
+common interface of the days, used by the runner (runner/runner.cpp) to run several days in one process.
+
+every day keeps its own main() and also exports a solver_t named <day>_solver (e.g. task_7_solver):
+- parse() reads the input at input_path and returns the parsed state, NULL on failure
+- part1() / part2() write the answer into answer (truncated to answer_size) and return false on failure
+- release() frees the state returned by parse()
+
+all the data of a run lives in its state, so different days can run on different threads.
+compiling a day with -DAOC_RUNNER leaves its main() out, so the days can be linked together.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SOLVER_ANSWER_SIZE 1024
+
+typedef struct
+{
+    const char* name;
+    void* (*parse)(const char* input_path);
+    bool (*part1)(void* state, char* answer, size_t answer_size);
+    bool (*part2)(void* state, char* answer, size_t answer_size);
+    void (*release)(void* state);
+} solver_t;
+
+static inline bool solver_answer_u64(char* answer, size_t answer_size, uint64_t value)
+{
+    snprintf(answer, answer_size, "%" PRIu64, value);
+    return true;
+}
+
+static inline bool solver_answer_str(char* answer, size_t answer_size, const char* value)
+{
+    snprintf(answer, answer_size, "%s", value);
+    return true;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef STREAM_READER_H
+#define STREAM_READER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "scanner.h"
+
+/*
+line reader for inputs that are too big to map or to keep around.
+
+the file is read into a ring of fixed size chunks. a background thread keeps
+filling the free chunks while the solver parses the current one, so the disk reads
+overlap with the parsing, and the memory use is bounded by num_chunks * chunk_size
+no matter how big the file is.
+
+a line that straddles two (or more) chunks is stitched in a small carry buffer,
+every other line is a std::string_view straight into the chunk.
+the view returned by next_line() is valid until the next call.
+
+line semantics match std::getline (see mapped_file.h).
+*/
+
+struct StreamReaderError : public std::runtime_error
+{
+    StreamReaderError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+class StreamReader
+{
+public:
+    static const size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+    static const size_t DEFAULT_NUM_CHUNKS = 2; // double buffering
+
+    explicit StreamReader(const std::string& path, size_t chunk_size = DEFAULT_CHUNK_SIZE, size_t num_chunks = DEFAULT_NUM_CHUNKS);
+    ~StreamReader();
+    StreamReader(const StreamReader&) = delete;
+    StreamReader& operator=(const StreamReader&) = delete;
+
+    // returns false when the file is exhausted
+    bool next_line(std::string_view& line);
+private:
+    struct Chunk
+    {
+        std::vector<char> data;
+        size_t length = 0;
+        bool is_last = false;   // no chunk will follow this one
+        bool has_error = false; // read() failed, is_last is set as well
+    };
+
+    int m_fd = -1;
+    std::string m_path;
+    std::vector<Chunk> m_chunks;
+
+    // ring state, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_chunk_filled;
+    std::condition_variable m_chunk_released;
+    size_t m_filled_count = 0; // chunks filled by the prefetch thread and not released by the reader yet
+    bool m_stop = false;
+    std::thread m_prefetch_thread;
+
+    // reader state, only touched by the consuming thread
+    Chunk* m_current = nullptr;
+    size_t m_read_index = 0;
+    size_t m_pos = 0;
+    std::string m_carry;
+    bool m_is_carry_returned = false;
+    bool m_is_done = false;
+
+    void prefetch_loop();
+    void acquire_chunk();
+    void release_chunk();
+};
+
+inline StreamReader::StreamReader(const std::string& path, size_t chunk_size, size_t num_chunks) :
+    m_path(path), m_chunks(num_chunks < 2 ? 2 : num_chunks)
+{
+    if(chunk_size == 0)
+    {
+        throw std::invalid_argument("StreamReader: chunk_size must be positive");
+    }
+    m_fd = open(path.c_str(), O_RDONLY);
+    if(m_fd < 0)
+    {
+        throw StreamReaderError("failed to open " + path);
+    }
+    posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    for(Chunk& chunk : m_chunks)
+    {
+        chunk.data.resize(chunk_size);
+    }
+    m_prefetch_thread = std::thread(&StreamReader::prefetch_loop, this);
+}
+
+inline StreamReader::~StreamReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_chunk_released.notify_all();
+    if(m_prefetch_thread.joinable())
+    {
+        m_prefetch_thread.join();
+    }
+    close(m_fd);
+}
+
+inline void StreamReader::prefetch_loop()
+{
+    size_t write_index = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_chunk_released.wait(lock, [this] { return m_stop || m_filled_count < m_chunks.size(); });
+            if(m_stop)
+                return;
+        }
+        // the slot at write_index is free, fill it without holding the lock
+        Chunk& chunk = m_chunks[write_index];
+        chunk.length = 0;
+        chunk.is_last = false;
+        chunk.has_error = false;
+        while(chunk.length < chunk.data.size())
+        {
+            ssize_t bytes_read = read(m_fd, chunk.data.data() + chunk.length, chunk.data.size() - chunk.length);
+            if(bytes_read < 0)
+            {
+                chunk.has_error = true;
+                chunk.is_last = true;
+                break;
+            }
+            if(bytes_read == 0)
+            {
+                chunk.is_last = true;
+                break;
+            }
+            chunk.length += static_cast<size_t>(bytes_read);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_filled_count++;
+        }
+        m_chunk_filled.notify_one();
+        if(chunk.is_last)
+            return;
+        write_index = (write_index + 1) % m_chunks.size();
+    }
+}
+
+inline void StreamReader::acquire_chunk()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_chunk_filled.wait(lock, [this] { return m_filled_count > 0; });
+    m_current = &m_chunks[m_read_index];
+    m_pos = 0;
+    if(m_current->has_error)
+    {
+        throw StreamReaderError("failed to read " + m_path);
+    }
+}
+
+inline void StreamReader::release_chunk()
+{
+    bool was_last = m_current->is_last;
+    m_current = nullptr;
+    m_read_index = (m_read_index + 1) % m_chunks.size();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_filled_count--;
+    }
+    m_chunk_released.notify_one();
+    if(was_last)
+        m_is_done = true;
+}
+
+inline bool StreamReader::next_line(std::string_view& line)
+{
+    if(m_is_carry_returned)
+    {
+        m_carry.clear();
+        m_is_carry_returned = false;
+    }
+    while(!m_is_done)
+    {
+        if(!m_current)
+        {
+            acquire_chunk();
+        }
+        const char* begin = m_current->data.data() + m_pos;
+        size_t remaining = m_current->length - m_pos;
+        size_t line_length = scan_find_char(begin, remaining, '\n');
+        if(line_length < remaining)
+        {
+            m_pos += line_length + 1;
+            if(m_carry.empty())
+            {
+                line = std::string_view(begin, line_length);
+            }
+            else
+            {
+                // the line started in a previous chunk
+                m_carry.append(begin, line_length);
+                line = m_carry;
+                m_is_carry_returned = true;
+            }
+            return true;
+        }
+        // no newline until the end of the chunk, keep the partial line for the next one
+        m_carry.append(begin, remaining);
+        release_chunk();
+    }
+    if(!m_carry.empty())
+    {
+        // the last line has no trailing newline
+        line = m_carry;
+        m_is_carry_returned = true;
+        return true;
+    }
+    return false;
+}
+
+#endif
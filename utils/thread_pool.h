@@ -0,0 +1,98 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/*
+fixed size pool of worker threads fed from a single FIFO queue.
+
+submit() returns a std::future of the task result, exceptions thrown by a task are
+rethrown by future::get(). the destructor lets the queued tasks finish before joining.
+*/
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_is_stopping = false;
+
+    void worker_loop()
+    {
+        while(true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this] { return m_is_stopping || !m_tasks.empty(); });
+                if(m_tasks.empty())
+                {
+                    return; // stopping and nothing left to run
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(size_t num_threads = 0)
+    {
+        if(num_threads == 0)
+        {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_workers.reserve(num_threads);
+        for(size_t i = 0; i < num_threads; i++)
+        {
+            m_workers.emplace_back(&ThreadPool::worker_loop, this);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_is_stopping = true;
+        }
+        m_condition.notify_all();
+        for(std::thread& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return m_workers.size(); }
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& function)
+    {
+        using result_t = std::invoke_result_t<F>;
+        // std::function must be copyable, so the (move only) packaged_task is shared
+        auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(function));
+        std::future<result_t> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace([task] { (*task)(); });
+        }
+        m_condition.notify_one();
+        return result;
+    }
+};
+
+#endif